@@ -8,13 +8,13 @@
 #include "src/UPS.h"
 
 int main() {
-    nut::Server server;
+    const std::shared_ptr<nut::Server> server = nut::Server::create();
 
-    server.connect();
+    server->connect();
 
-    const std::vector<nut::UPS> list = server.get_ups_list();
+    const std::vector<nut::UPS> list = server->get_ups_list();
 
-    const nut::UPS dummy_ups(server.get_ups("dummy"));
+    const nut::UPS dummy_ups(server->get_ups("dummy"));
 
     std::cout << dummy_ups.get_description() << std::endl;
     std::cout << dummy_ups.get_charge() << std::endl;
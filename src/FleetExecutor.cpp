@@ -0,0 +1,350 @@
+// Runs queries against many NUT servers in parallel on a work-stealing thread pool.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "FleetExecutor.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "Server.h"
+#include "exceptions/ConnectionException.h"
+
+namespace nut {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct FleetStream::State {
+        FleetQuery query;
+        std::vector<FleetHost> hosts;
+        Clock::time_point deadline;
+        std::atomic<bool> cancelled{false};
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<FleetResult> ready;
+        std::vector<bool> reported;
+        size_t pending = 0;
+
+        [[nodiscard]] bool expired() const {
+            return cancelled || Clock::now() >= deadline;
+        }
+
+        void report(const size_t index, FleetResult&& result) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (reported[index]) {
+                    return;
+                }
+                reported[index] = true;
+                --pending;
+                ready.emplace_back(std::move(result));
+            }
+            cv.notify_all();
+        }
+    };
+
+    struct FleetExecutor::Task {
+        std::shared_ptr<FleetStream::State> state;
+        size_t index = 0;
+        // Worker whose queue the task was placed on, and which caches the host's connection.
+        size_t owner = 0;
+    };
+
+    struct FleetExecutor::Worker {
+        struct Connection {
+            std::shared_ptr<Server> server;
+            uint64_t last_used = 0;
+        };
+
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        // Only touched by the owning thread, so connections never move between threads.
+        std::unordered_map<std::string, Connection> connections;
+        uint64_t use_counter = 0;
+    };
+
+    FleetStream::FleetStream(std::shared_ptr<State> state) :
+        m_state(std::move(state))
+    {}
+
+    FleetStream::~FleetStream() {
+        cancel();
+    }
+
+    FleetStream::FleetStream(FleetStream&&) noexcept = default;
+
+    FleetStream& FleetStream::operator=(FleetStream&& other) noexcept {
+        if (this != &other) {
+            cancel();
+            m_state = std::move(other.m_state);
+        }
+        return *this;
+    }
+
+    bool FleetStream::next(FleetResult& result) {
+        if (!m_state) {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(m_state->mutex);
+
+        const bool woken = m_state->cv.wait_until(lock, m_state->deadline, [this] {
+            return !m_state->ready.empty() || m_state->pending == 0 || m_state->cancelled;
+        });
+
+        // Deadline passed or cancelled: stop waiting on hosts that are still running.
+        if (m_state->ready.empty() && (!woken || m_state->cancelled)) {
+            for (size_t i = 0; i < m_state->hosts.size(); ++i) {
+                if (!m_state->reported[i]) {
+                    m_state->reported[i] = true;
+                    FleetResult timed_out;
+                    timed_out.host = m_state->hosts[i];
+                    timed_out.timed_out = true;
+                    m_state->ready.emplace_back(std::move(timed_out));
+                }
+            }
+            m_state->pending = 0;
+        }
+
+        if (m_state->ready.empty()) {
+            return false;
+        }
+
+        result = std::move(m_state->ready.front());
+        m_state->ready.pop_front();
+        return true;
+    }
+
+    void FleetStream::cancel() {
+        if (!m_state) {
+            return;
+        }
+
+        m_state->cancelled = true;
+        m_state->cv.notify_all();
+    }
+
+    FleetExecutor::FleetExecutor(size_t num_threads, const size_t max_cached_connections) :
+        m_max_cached_connections(max_cached_connections)
+    {
+        if (num_threads == 0) {
+            num_threads = 1;
+        }
+
+        for (size_t i = 0; i < num_threads; ++i) {
+            m_workers.emplace_back(std::make_unique<Worker>());
+        }
+
+        for (size_t i = 0; i < num_threads; ++i) {
+            m_threads.emplace_back(&FleetExecutor::run_worker, this, i);
+        }
+    }
+
+    FleetExecutor::~FleetExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(m_idle_mutex);
+            m_stopping = true;
+        }
+        m_idle_cv.notify_all();
+
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    FleetStream FleetExecutor::run(const std::vector<FleetHost>& hosts, FleetQuery query, const std::chrono::milliseconds timeout) {
+        auto state = std::make_shared<FleetStream::State>();
+        state->query = std::move(query);
+        state->hosts = hosts;
+        state->deadline = Clock::now() + timeout;
+        state->reported.assign(hosts.size(), false);
+        state->pending = hosts.size();
+
+        // Count first so a worker never sees a task it cannot account for.
+        m_queued += hosts.size();
+
+        const std::hash<std::string> hasher;
+        for (size_t i = 0; i < hosts.size(); ++i) {
+            const std::string key = hosts[i].hostname + ":" + std::to_string(hosts[i].port);
+            const size_t owner = hasher(key) % m_workers.size();
+            Worker& worker = *m_workers[owner];
+
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.push_back({state, i, owner});
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_idle_mutex);
+        }
+        m_idle_cv.notify_all();
+
+        return FleetStream(state);
+    }
+
+    bool FleetExecutor::pop_task(const size_t index, Task& task) {
+        {
+            Worker& own = *m_workers[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.front());
+                own.tasks.pop_front();
+                --m_queued;
+                return true;
+            }
+        }
+
+        // Steal from the back so the victim keeps working through its hosts in order.
+        for (size_t offset = 1; offset < m_workers.size(); ++offset) {
+            Worker& victim = *m_workers[(index + offset) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.back());
+                victim.tasks.pop_back();
+                --m_queued;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void FleetExecutor::run_worker(const size_t index) {
+        while (true) {
+            Task task;
+            if (pop_task(index, task)) {
+                execute(index, task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_idle_mutex);
+            m_idle_cv.wait(lock, [this] {
+                return m_stopping || m_queued > 0;
+            });
+
+            if (m_stopping && m_queued == 0) {
+                return;
+            }
+        }
+    }
+
+    void FleetExecutor::execute(const size_t index, Task& task) {
+        Worker& worker = *m_workers[index];
+        FleetStream::State& state = *task.state;
+        const FleetHost& host = state.hosts[task.index];
+        const auto expired = [this, &state] {
+            return m_stopping || state.expired();
+        };
+        const auto remaining = [&state] {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(state.deadline - Clock::now());
+            return std::max(left, std::chrono::milliseconds(1));
+        };
+
+        FleetResult result;
+        result.host = host;
+        const Clock::time_point start = Clock::now();
+
+        if (expired()) {
+            result.timed_out = true;
+            state.report(task.index, std::move(result));
+            return;
+        }
+
+        // Only the owning worker caches the host's connection. A stolen task connects for this query alone.
+        const bool cacheable = task.owner == index && m_max_cached_connections > 0;
+        const std::string key = host.hostname + ":" + std::to_string(host.port);
+        std::shared_ptr<Server> connection;
+
+        if (cacheable) {
+            const auto cached = worker.connections.find(key);
+            if (cached != worker.connections.end()) {
+                connection = std::move(cached->second.server);
+                worker.connections.erase(cached);
+            }
+        }
+        bool reused = connection != nullptr;
+
+        while (true) {
+            try {
+                if (!connection) {
+                    auto server = Server::create(host.hostname, host.port);
+                    server->set_ssl_mode(host.ssl_mode);
+                    server->connect(remaining());
+                    connection = std::move(server);
+                }
+
+                connection->set_io_timeout(remaining());
+                result.rows = state.query(*connection, expired);
+                result.timed_out = expired();
+            } catch (const ConnectionException&) {
+                connection.reset();
+
+                // A cached connection may have been closed by upsd while idle, so retry once on a fresh one.
+                if (reused && !expired()) {
+                    reused = false;
+                    continue;
+                }
+                result.error = std::current_exception();
+            } catch (...) {
+                result.error = std::current_exception();
+            }
+            break;
+        }
+
+        // After an error or timeout the connection may still hold unread replies, so it is never reused.
+        if (result.error || result.timed_out) {
+            connection.reset();
+        }
+
+        if (cacheable && connection) {
+            if (worker.connections.size() >= m_max_cached_connections) {
+                const auto oldest = std::min_element(worker.connections.begin(), worker.connections.end(),
+                    [](const auto& a, const auto& b) {
+                        return a.second.last_used < b.second.last_used;
+                    });
+                worker.connections.erase(oldest);
+            }
+            worker.connections[key] = { std::move(connection), ++worker.use_counter };
+        }
+
+        result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+        state.report(task.index, std::move(result));
+    }
+
+    FleetQuery FleetExecutor::snapshot_query() {
+        return [](const Server& server, const std::function<bool()>& expired) {
+            std::vector<std::vector<std::string>> rows;
+
+            for (const std::vector<std::string>& ups : server.get_var_list("UPS")) {
+                if (expired()) {
+                    break;
+                }
+
+                for (const std::vector<std::string>& var : server.get_var_list(ups.at(1), "VAR")) {
+                    rows.push_back({ var.at(1), var.at(2), var.at(3) });
+                }
+            }
+
+            return rows;
+        };
+    }
+} // nut
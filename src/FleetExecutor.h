@@ -0,0 +1,145 @@
+// Runs queries against many NUT servers in parallel on a work-stealing thread pool.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef NUT_PLUS_PLUS_FLEETEXECUTOR_H
+#define NUT_PLUS_PLUS_FLEETEXECUTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Server.h"
+
+namespace nut {
+
+    struct FleetHost {
+        std::string hostname;
+        int port = 3493;
+        SSLMode ssl_mode = SSLMode::TRY;
+    };
+
+    struct FleetResult {
+        FleetHost host;
+        std::vector<std::vector<std::string>> rows;
+        // Set if the query threw; rethrow with std::rethrow_exception.
+        std::exception_ptr error;
+        // Set if the deadline passed before the query could complete. Rows may be partial.
+        bool timed_out = false;
+        std::chrono::milliseconds elapsed{0};
+    };
+
+    /**
+     * Query run once per host. The second argument returns true once the sweep deadline has passed or the
+     * sweep was cancelled, and long-running queries should poll it between requests.
+     */
+    using FleetQuery = std::function<std::vector<std::vector<std::string>>(const Server&, const std::function<bool()>&)>;
+
+    /**
+     * Stream of per-host results of a single sweep, in completion order.
+     */
+    class FleetStream {
+        public:
+            struct State;
+
+            explicit FleetStream(std::shared_ptr<State> state);
+            ~FleetStream();
+
+            FleetStream(FleetStream&&) noexcept;
+            FleetStream& operator=(FleetStream&&) noexcept;
+
+            /**
+             * Wait for next result. Returns false once every host has reported or the deadline has passed;
+             * hosts still running at the deadline are reported with timed_out set.
+             * @param result receives the next result
+             * @return true if a result was written
+             */
+            bool next(FleetResult& result);
+
+            /**
+             * Stop the sweep. Hosts not yet started are reported as timed out.
+             */
+            void cancel();
+
+        private:
+            std::shared_ptr<State> m_state;
+    };
+
+    class FleetExecutor {
+        private:
+            struct Task;
+            struct Worker;
+
+            std::vector<std::unique_ptr<Worker>> m_workers;
+            const size_t m_max_cached_connections;
+            std::vector<std::thread> m_threads;
+            std::mutex m_idle_mutex;
+            std::condition_variable m_idle_cv;
+            std::atomic<size_t> m_queued{0};
+            std::atomic<bool> m_stopping{false};
+
+            void run_worker(size_t index);
+            bool pop_task(size_t index, Task& task);
+            void execute(size_t index, Task& task);
+        public:
+            // Default number of workers. Tasks spend their time blocked on the network, not on the CPU.
+            static constexpr size_t DEFAULT_NUM_THREADS = 64;
+
+            /**
+             * Start worker threads. Each worker queries one host at a time, so a sweep only finishes within the
+             * latency of its slowest host if there are at least as many workers as hosts; with fewer, it takes
+             * about hosts / num_threads host latencies. Size the pool to the fleet.
+             * @param num_threads number of workers
+             * @param max_cached_connections idle connections each worker keeps open, least recently used first out
+             */
+            explicit FleetExecutor(size_t num_threads = DEFAULT_NUM_THREADS, size_t max_cached_connections = 64);
+            ~FleetExecutor();
+
+            FleetExecutor(const FleetExecutor&) = delete;
+            FleetExecutor& operator=(const FleetExecutor&) = delete;
+
+            /**
+             * Split query into one task per host and schedule them. Tasks for a host are queued on the worker
+             * holding its connection and are stolen by idle workers. A stolen task uses a short-lived connection,
+             * so each host keeps at most one cached connection. Connects and socket reads are limited to the time
+             * left until the deadline, so a worker stuck on an unreachable host is freed by the deadline too.
+             * @param hosts servers to query
+             * @param query query to run against each server
+             * @param timeout time budget of the whole sweep
+             * @return stream of results
+             */
+            [[nodiscard]] FleetStream run(const std::vector<FleetHost>& hosts, FleetQuery query, std::chrono::milliseconds timeout);
+
+            /**
+             * Query returning every variable of every UPS on a server as {ups, variable, value} rows.
+             * @return FleetQuery
+             */
+            [[nodiscard]] static FleetQuery snapshot_query();
+    };
+} // nut
+
+#endif //NUT_PLUS_PLUS_FLEETEXECUTOR_H
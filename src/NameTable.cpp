@@ -0,0 +1,128 @@
+// Process-wide table of interned UPS names.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "NameTable.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include "exceptions/ClientException.h"
+
+namespace nut {
+
+    namespace {
+        // Segment k holds FIRST_SEGMENT << k names, so 26 segments cover every 32-bit id.
+        constexpr size_t FIRST_SEGMENT = 64;
+        constexpr size_t NUM_SEGMENTS = 26;
+
+        struct Storage {
+            // Guards ids and appends. lookup() never takes it.
+            std::shared_mutex mutex;
+            std::unordered_map<std::string_view, NameId> ids;
+            // Segments are never moved or freed, so the string_view keys and returned references stay valid.
+            std::unique_ptr<std::string[]> segments[NUM_SEGMENTS];
+            // Names below this id are fully constructed. Published with release after each append.
+            std::atomic<NameId> size{0};
+        };
+
+        Storage& storage() {
+            static Storage instance;
+            return instance;
+        }
+
+        void locate(const NameId id, size_t& segment, size_t& offset) {
+            const size_t block = id / FIRST_SEGMENT + 1;
+            segment = 0;
+            while ((block >> (segment + 1)) != 0) {
+                ++segment;
+            }
+            offset = id - FIRST_SEGMENT * ((size_t{1} << segment) - 1);
+        }
+    }
+
+    NameId NameTable::intern(const std::string& name) {
+        Storage& table = storage();
+
+        {
+            std::shared_lock<std::shared_mutex> lock(table.mutex);
+            const auto it = table.ids.find(name);
+            if (it != table.ids.end()) {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(table.mutex);
+        const auto it = table.ids.find(name);
+        if (it != table.ids.end()) {
+            return it->second;
+        }
+
+        const NameId id = table.size.load(std::memory_order_relaxed);
+        size_t segment;
+        size_t offset;
+        locate(id, segment, offset);
+        if (segment >= NUM_SEGMENTS) {
+            throw ClientException("Name table is full.");
+        }
+        if (!table.segments[segment]) {
+            table.segments[segment] = std::make_unique<std::string[]>(FIRST_SEGMENT << segment);
+        }
+
+        std::string& slot = table.segments[segment][offset];
+        slot = name;
+        table.ids.emplace(slot, id);
+        table.size.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    bool NameTable::find(const std::string& name, NameId& id) {
+        Storage& table = storage();
+        std::shared_lock<std::shared_mutex> lock(table.mutex);
+
+        const auto it = table.ids.find(name);
+        if (it == table.ids.end()) {
+            return false;
+        }
+
+        id = it->second;
+        return true;
+    }
+
+    const std::string& NameTable::lookup(const NameId id) {
+        Storage& table = storage();
+
+        if (id >= table.size.load(std::memory_order_acquire)) {
+            throw ClientException("Unknown name id " + std::to_string(id) + ".");
+        }
+
+        size_t segment;
+        size_t offset;
+        locate(id, segment, offset);
+        return table.segments[segment][offset];
+    }
+
+    size_t NameTable::size() {
+        return storage().size.load(std::memory_order_acquire);
+    }
+} // nut
@@ -0,0 +1,69 @@
+// Process-wide table of interned UPS names.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef NUT_PLUS_PLUS_NAMETABLE_H
+#define NUT_PLUS_PLUS_NAMETABLE_H
+
+#include <cstdint>
+#include <string>
+
+namespace nut {
+
+    using NameId = uint32_t;
+
+    /**
+     * Interns UPS names so handles can store a NameId instead of a copy of the string. Interned strings live
+     * until the process exits and references returned by lookup() never dangle, so only intern bounded sets
+     * such as UPS names. Safe to use from any thread; lookup() is lock-free.
+     */
+    class NameTable {
+        public:
+            /**
+             * Get id of string, adding it to the table if not yet present.
+             * @param name string to intern
+             * @return NameId of string
+             */
+            static NameId intern(const std::string& name);
+
+            /**
+             * Get id of string without adding it to the table.
+             * @param name string to find
+             * @param id receives NameId of string if found
+             * @return true if string has been interned
+             */
+            static bool find(const std::string& name, NameId& id);
+
+            /**
+             * Get string for an id returned by intern().
+             * @param id NameId of string
+             * @return interned string
+             * @throws ClientException
+             */
+            [[nodiscard]] static const std::string& lookup(NameId id);
+
+            /**
+             * Get number of interned strings.
+             * @return size_t count
+             */
+            [[nodiscard]] static size_t size();
+    };
+} // nut
+
+#endif //NUT_PLUS_PLUS_NAMETABLE_H
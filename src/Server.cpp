@@ -21,10 +21,17 @@
 #include "Server.h"
 #include "UPS.h"
 
+#include <algorithm>
+#include <initializer_list>
 #include <iostream>
+#include <mutex>
 #include <upsclient.h>
 #include <ostream>
 #include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unordered_map>
 #include <utility>
 
 #include "exceptions/AuthenticationException.h"
@@ -35,10 +42,156 @@
 #include "exceptions/VariableException.h"
 
 namespace nut {
-    Server::Server(std::string hostname, const int port):
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        // How long a refused STARTTLS is remembered before TRY mode attempts TLS again.
+        constexpr auto PLAIN_TEXT_TTL = std::chrono::minutes(5);
+
+        std::mutex plain_text_hosts_mutex;
+        std::unordered_map<std::string, Clock::time_point> plain_text_hosts;
+
+        // ERR tokens sent by upsd, mapped to the matching upscli error codes.
+        const std::unordered_map<std::string, int> UPSD_ERRORS = {
+            { "VAR-NOT-SUPPORTED", UPSCLI_ERR_VARNOTSUPP },
+            { "UNKNOWN-UPS", UPSCLI_ERR_UNKNOWNUPS },
+            { "ACCESS-DENIED", UPSCLI_ERR_ACCESSDENIED },
+            { "PASSWORD-REQUIRED", UPSCLI_ERR_PWDREQUIRED },
+            { "PASSWORD-INCORRECT", UPSCLI_ERR_PWDINCORRECT },
+            { "MISSING-ARGUMENT", UPSCLI_ERR_MISSINGARG },
+            { "DATA-STALE", UPSCLI_ERR_DATASTALE },
+            { "VAR-UNKNOWN", UPSCLI_ERR_VARUNKNOWN },
+            { "ALREADY-LOGGED-IN", UPSCLI_ERR_LOGINTWICE },
+            { "ALREADY-SET-PASSWORD", UPSCLI_ERR_PWDSETTWICE },
+            { "UNKNOWN-TYPE", UPSCLI_ERR_UNKNOWNTYPE },
+            { "UNKNOWN-VAR", UPSCLI_ERR_UNKNOWNVAR },
+            { "READONLY", UPSCLI_ERR_VARREADONLY },
+            { "TOO-LONG", UPSCLI_ERR_TOOLONG },
+            { "INVALID-VALUE", UPSCLI_ERR_INVALIDVALUE },
+            { "SET-FAILED", UPSCLI_ERR_SETFAILED },
+            { "UNKNOWN-INSTCMD", UPSCLI_ERR_UNKINSTCMD },
+            { "INSTCMD-FAILED", UPSCLI_ERR_CMDFAILED },
+            { "CMD-NOT-SUPPORTED", UPSCLI_ERR_CMDNOTSUPP },
+            { "INVALID-USERNAME", UPSCLI_ERR_INVUSERNAME },
+            { "ALREADY-SET-USERNAME", UPSCLI_ERR_USERSETTWICE },
+            { "UNKNOWN-COMMAND", UPSCLI_ERR_UNKCOMMAND },
+            { "INVALID-ARGUMENT", UPSCLI_ERR_INVALIDARG },
+            { "DRIVER-NOT-CONNECTED", UPSCLI_ERR_DRVNOTCONN },
+            { "USERNAME-REQUIRED", UPSCLI_ERR_USERREQUIRED },
+            { "INVALID-PASSWORD", UPSCLI_ERR_INVPASSWORD }
+        };
+
+        // Requests sent before their replies are read, small enough that neither side fills its socket buffer.
+        constexpr size_t PIPELINE_DEPTH = 32;
+
+        // Longest reply line read at once, the network buffer size of libupsclient.
+        constexpr size_t MAX_LINE_LENGTH = 512;
+
+        // Names are sent unquoted, so anything that would end the token or the line is rejected.
+        bool is_protocol_word(const std::string_view word) {
+            if (word.empty()) {
+                return false;
+            }
+
+            for (const char c : word) {
+                const auto byte = static_cast<unsigned char>(c);
+                if (byte <= 0x20 || byte == 0x7F || c == '"' || c == '\\') {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void require_names(const std::initializer_list<std::string_view> names) {
+            for (const std::string_view name : names) {
+                if (!is_protocol_word(name)) {
+                    throw ClientException("UPS and variable names may not be empty or contain whitespace, quotes or control characters.");
+                }
+            }
+        }
+
+        bool has_line_break(const std::string& value) {
+            return value.find_first_of("\r\n") != std::string::npos;
+        }
+
+        std::string quote(const std::string& value) {
+            std::string quoted = "\"";
+            for (const char c : value) {
+                if (c == '"' || c == '\\') {
+                    quoted += '\\';
+                }
+                quoted += c;
+            }
+            return quoted + "\"";
+        }
+
+        // Splits a reply line the way libupsclient does: words separated by spaces, where a quoted word may hold
+        // spaces and backslash escapes.
+        std::vector<std::string> split_reply(const std::string& line) {
+            std::vector<std::string> words;
+            std::string current;
+            bool quoted = false;
+            bool in_word = false;
+
+            for (size_t i = 0; i < line.size(); ++i) {
+                const char c = line[i];
+                if (c == '\\' && quoted && i + 1 < line.size()) {
+                    current += line[++i];
+                } else if (c == '"') {
+                    quoted = !quoted;
+                    in_word = true;
+                } else if (c == ' ' && !quoted) {
+                    if (in_word) {
+                        words.emplace_back(std::move(current));
+                        current.clear();
+                        in_word = false;
+                    }
+                } else {
+                    current += c;
+                    in_word = true;
+                }
+            }
+
+            if (in_word) {
+                words.emplace_back(std::move(current));
+            }
+
+            return words;
+        }
+
+        std::string host_key(const std::string& hostname, const int port) {
+            return hostname + ":" + std::to_string(port);
+        }
+
+        bool refused_tls_recently(const std::string& key) {
+            std::lock_guard<std::mutex> lock(plain_text_hosts_mutex);
+            const auto it = plain_text_hosts.find(key);
+            if (it == plain_text_hosts.end()) {
+                return false;
+            }
+            if (Clock::now() - it->second > PLAIN_TEXT_TTL) {
+                plain_text_hosts.erase(it);
+                return false;
+            }
+            return true;
+        }
+
+        void record_tls_result(const std::string& key, const bool tls_active) {
+            std::lock_guard<std::mutex> lock(plain_text_hosts_mutex);
+            if (tls_active) {
+                plain_text_hosts.erase(key);
+            } else {
+                plain_text_hosts[key] = Clock::now();
+            }
+        }
+    }
+
+    Server::Server(Passkey, std::string hostname, const int port):
+        m_connection{},
         m_hostname(std::move(hostname)),
-        m_port(port),
-        m_connection{}
+        m_port(port)
     {}
 
     Server::~Server() {
@@ -47,13 +200,131 @@ namespace nut {
         }
     }
 
-    void Server::connect() {
-        int result = upscli_connect(get_handle(), get_hostname().c_str(), get_port(), UPSCLI_CONN_TRYSSL);
+    std::shared_ptr<Server> Server::create(std::string hostname, const int port) {
+        return std::make_shared<Server>(Passkey(), std::move(hostname), port);
+    }
+
+    void Server::init_ssl(const std::string& cert_path, const bool verify_certificate,
+                          const std::string& cert_name, const std::string& cert_password) {
+        const int result = upscli_init(verify_certificate ? 1 : 0,
+                                       cert_path.empty() ? nullptr : cert_path.c_str(),
+                                       cert_name.empty() ? nullptr : cert_name.c_str(),
+                                       cert_password.empty() ? nullptr : cert_password.c_str());
+
+        if (result != 1) {
+            throw ClientException("Failed to initialize SSL support of libupsclient.");
+        }
+    }
+
+    void Server::set_ssl_mode(const SSLMode ssl_mode, const bool verify_certificate) {
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+        m_ssl_mode = ssl_mode;
+        m_verify_certificate = verify_certificate;
+    }
+
+    void Server::set_remember_tls_refusal(const bool enabled) {
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+        m_remember_tls_refusal = enabled;
+    }
+
+    void Server::connect(const std::chrono::milliseconds timeout) {
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+        m_connect_timeout = timeout;
+        const std::string key = host_key(get_hostname(), get_port());
+        int flags = 0;
+        const bool use_refusal_cache = m_remember_tls_refusal && !m_verify_certificate;
+
+        m_stats.tls_skipped = false;
+        switch (m_ssl_mode) {
+            case SSLMode::PLAIN:
+                break;
+            case SSLMode::TRY:
+                if (use_refusal_cache && refused_tls_recently(key)) {
+                    m_stats.tls_skipped = true;
+                } else {
+                    flags |= UPSCLI_CONN_TRYSSL;
+                }
+                break;
+            case SSLMode::REQUIRE:
+                flags |= UPSCLI_CONN_REQSSL;
+                break;
+        }
+
+        if (m_verify_certificate && flags != 0) {
+            flags |= UPSCLI_CONN_CERTVERIF;
+        }
+
+        const Clock::time_point start = Clock::now();
+        timeval limit{};
+        limit.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+        limit.tv_usec = static_cast<suseconds_t>(timeout.count() % 1000 * 1000);
+        int result = upscli_tryconnect(get_handle(), get_hostname().c_str(), static_cast<uint16_t>(get_port()), flags,
+                                       timeout.count() > 0 ? &limit : nullptr);
+
+        m_stats.last_connect_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+        m_stats.total_connect_time += m_stats.last_connect_time;
+        ++m_stats.connect_count;
 
         if (result != 0) {
+            m_stats.tls_active = false;
             upscli_disconnect(&m_connection);
             handle_error();
         }
+
+        m_stats.tls_active = upscli_ssl(get_handle()) == 1;
+        if (use_refusal_cache && (flags & UPSCLI_CONN_TRYSSL)) {
+            record_tls_result(key, m_stats.tls_active);
+        }
+    }
+
+    void Server::set_io_timeout(const std::chrono::milliseconds timeout) {
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+        m_io_timeout = timeout;
+        timeval limit{};
+        limit.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+        limit.tv_usec = static_cast<suseconds_t>(timeout.count() % 1000 * 1000);
+
+        const int fd = upscli_fd(get_handle());
+        if (fd < 0 ||
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit)) != 0 ||
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit)) != 0) {
+            throw ConnectionException("Failed to set I/O timeout on connection to " + get_hostname() + ".");
+        }
+    }
+
+    void Server::reconnect() {
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+        upscli_disconnect(&m_connection);
+        m_connection = {};
+        connect(m_connect_timeout);
+
+        if (m_io_timeout.count() > 0) {
+            set_io_timeout(m_io_timeout);
+        }
+
+        if (!m_username.empty()) {
+            log_in(m_username, m_password);
+        }
+    }
+
+    void Server::authenticate(const std::string& username, const std::string& password) {
+        if (!is_protocol_word(username)) {
+            throw ClientException("User name may not be empty or contain whitespace, quotes or control characters.");
+        }
+        if (has_line_break(password)) {
+            throw ClientException("Password may not contain line breaks.");
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+        log_in(username, password);
+        m_username = username;
+        m_password = password;
+    }
+
+    void Server::log_in(const std::string& username, const std::string& password) const {
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+        command("USERNAME " + username + "\n", "USERNAME");
+        command("PASSWORD " + quote(password) + "\n", "PASSWORD");
     }
 
     std::string Server::get_var(const std::string &ups_name, const std::string &var_key) const {
@@ -61,6 +332,7 @@ namespace nut {
         size_t num_queries = 3;
         size_t num_answers;
         char** answer_list;
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
 
         if (upscli_get(get_handle(), num_queries, query, &num_answers, &answer_list) != 0) {
             handle_error();
@@ -93,31 +365,197 @@ namespace nut {
     }
 
     std::vector<std::vector<std::string>> Server::get_var_list(const std::string &ups_name, const std::string &var_key) const {
-        std::vector<std::vector<std::string>> result;
+        if (ups_name.empty()) {
+            return list({ var_key.c_str() });
+        }
+
+        return list({ var_key.c_str(), ups_name.c_str() });
+    }
+
+    std::vector<std::vector<std::string>> Server::get_var_sublist(const std::string &ups_name, const std::string &var_name, const std::string &list_key) const {
+        return list({ list_key.c_str(), ups_name.c_str(), var_name.c_str() });
+    }
+
+    std::vector<std::string> Server::get_var_type(const std::string &ups_name, const std::string &var_name) const {
+        std::vector<std::string> answer = get({ "TYPE", ups_name.c_str(), var_name.c_str() });
+
+        if (answer.size() < 4) {
+            throw ClientException("Unexpected response length.");
+        }
+
+        return { answer.begin() + 3, answer.end() };
+    }
+
+    std::vector<std::vector<std::string>> Server::get_var_types(const std::string &ups_name, const std::vector<std::string> &var_names) const {
+        std::vector<std::string> requests;
+        requests.reserve(var_names.size());
 
-        std::vector<const char*> query;
-        size_t num_queries;
+        for (const std::string& var_name : var_names) {
+            require_names({ ups_name, var_name });
+            requests.emplace_back("GET TYPE " + ups_name + " " + var_name + "\n");
+        }
+
+        std::vector<std::vector<std::string>> types;
+        types.reserve(var_names.size());
+
+        for (const std::vector<std::vector<std::string>>& reply : pipeline(requests)) {
+            if (reply.size() != 1 || reply[0].size() < 4 || reply[0][0] != "TYPE") {
+                throw ClientException("Unexpected response to GET TYPE.");
+            }
+            types.emplace_back(reply[0].begin() + 3, reply[0].end());
+        }
+
+        return types;
+    }
+
+    std::vector<std::vector<std::vector<std::string>>> Server::get_var_sublists(const std::string &ups_name, const std::vector<std::pair<std::string, std::string>> &queries) const {
+        std::vector<std::string> requests;
+        requests.reserve(queries.size());
+
+        for (const auto& [list_key, var_name] : queries) {
+            require_names({ list_key, ups_name, var_name });
+            requests.emplace_back("LIST " + list_key + " " + ups_name + " " + var_name + "\n");
+        }
+
+        return pipeline(requests);
+    }
+
+    std::string Server::get_var_description(const std::string &ups_name, const std::string &var_name) const {
+        std::vector<std::string> answer = get({ "DESC", ups_name.c_str(), var_name.c_str() });
+
+        if (answer.size() != 4) {
+            throw ClientException("Unexpected response length.");
+        }
+
+        return answer[3];
+    }
+
+    void Server::set_var(const std::string &ups_name, const std::string &var_name, const std::string &value) const {
+        require_names({ ups_name, var_name });
+        if (has_line_break(value)) {
+            throw VariableException("Variable value may not contain line breaks.");
+        }
+
+        const std::string reply = command("SET VAR " + ups_name + " " + var_name + " " + quote(value) + "\n", "SET VAR");
+
+        if (reply.rfind("OK", 0) != 0) {
+            throw ClientException("Unexpected response to SET VAR: " + reply);
+        }
+    }
+
+    std::string Server::command(const std::string& request, const std::string& context) const {
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+        if (upscli_sendline(get_handle(), request.c_str(), request.size()) < 0) {
+            handle_error();
+        }
+
+        std::string reply = read_line();
+        if (reply.rfind("ERR", 0) == 0) {
+            throw_reply_error(reply, context);
+        }
+
+        return reply;
+    }
+
+    std::string Server::read_line() const {
+        char response[MAX_LINE_LENGTH];
+
+        if (upscli_readline(get_handle(), response, sizeof(response)) < 0) {
+            handle_error();
+        }
+
+        std::string line(response);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+            line.pop_back();
+        }
+
+        return line;
+    }
+
+    std::vector<std::vector<std::vector<std::string>>> Server::pipeline(const std::vector<std::string>& requests) const {
+        std::vector<std::vector<std::vector<std::string>>> replies(requests.size());
+        std::string error;
+        size_t error_index = 0;
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+
+        for (size_t begin = 0; begin < requests.size() && error.empty(); begin += PIPELINE_DEPTH) {
+            const size_t end = std::min(begin + PIPELINE_DEPTH, requests.size());
+
+            std::string batch;
+            for (size_t i = begin; i < end; ++i) {
+                batch += requests[i];
+            }
+
+            if (upscli_sendline(get_handle(), batch.c_str(), batch.size()) < 0) {
+                handle_error();
+            }
+
+            // Every reply of the batch is read even after an error, so the connection stays usable.
+            for (size_t i = begin; i < end; ++i) {
+                const std::string line = read_line();
+
+                if (line.rfind("ERR", 0) == 0) {
+                    if (error.empty()) {
+                        error = line;
+                        error_index = i;
+                    }
+                    continue;
+                }
+
+                if (requests[i].rfind("LIST ", 0) != 0) {
+                    replies[i].emplace_back(split_reply(line));
+                    continue;
+                }
+
+                if (line.rfind("BEGIN LIST ", 0) != 0) {
+                    throw ClientException("Unexpected response: " + line);
+                }
+
+                for (std::string row = read_line(); row.rfind("END LIST ", 0) != 0; row = read_line()) {
+                    replies[i].emplace_back(split_reply(row));
+                }
+            }
+        }
+
+        if (!error.empty()) {
+            const std::string& request = requests[error_index];
+            throw_reply_error(error, request.substr(0, request.size() - 1));
+        }
+
+        return replies;
+    }
+
+    std::vector<std::string> Server::get(std::vector<const char*> query) const {
         size_t num_answers;
         char** answer_list;
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
 
-        if (ups_name.empty()) {
-            query = { var_key.c_str() };
-            num_queries = 1;
-        } else {
-            query = { var_key.c_str(), ups_name.c_str() };
-            num_queries = 2;
+        if (upscli_get(get_handle(), query.size(), query.data(), &num_answers, &answer_list) != 0) {
+            handle_error();
         }
 
-        if (upscli_list_start(get_handle(), num_queries, query.data()) != 0) {
+        return { answer_list, answer_list + num_answers };
+    }
+
+    std::vector<std::vector<std::string>> Server::list(std::vector<const char*> query) const {
+        std::vector<std::vector<std::string>> result;
+
+        size_t num_answers;
+        char** answer_list;
+        std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+
+        if (upscli_list_start(get_handle(), query.size(), query.data()) != 0) {
             handle_error();
         }
 
-        while (upscli_list_next(get_handle(), num_queries, query.data(), &num_answers, &answer_list) == 1) {
-            std::vector<std::string> answer_vector;
-            for (int i = 0; i < num_answers; ++i) {
-                answer_vector.emplace_back(answer_list[i]);
-            }
-            result.emplace_back(answer_vector);
+        int status;
+        while ((status = upscli_list_next(get_handle(), query.size(), query.data(), &num_answers, &answer_list)) == 1) {
+            result.emplace_back(answer_list, answer_list + num_answers);
+        }
+
+        // A read error or I/O timeout mid-list must not pass for the end of the list.
+        if (status < 0) {
+            handle_error();
         }
 
         return result;
@@ -128,6 +566,7 @@ namespace nut {
         size_t num_queries = 2;
         size_t num_answers;
         char** answer_list;
+        std::unique_lock<std::recursive_mutex> lock(m_connection_mutex);
 
         if (upscli_get(get_handle(), num_queries, query, &num_answers, &answer_list) != 0) {
             handle_error();
@@ -137,24 +576,75 @@ namespace nut {
             throw ClientException("Unexpected response length.");
         }
 
-        return {*this, ups_name.c_str(), answer_list[2]};
+        const std::string description = answer_list[2];
+        lock.unlock();
+
+        const NameId ups_id = NameTable::intern(ups_name);
+        remember_description(ups_id, description);
+        return {shared_from_this(), ups_id};
+    }
+
+    UPS Server::get_ups(const NameId ups_id) const {
+        {
+            std::lock_guard<std::mutex> lock(m_descriptions_mutex);
+            if (m_descriptions.count(ups_id) != 0) {
+                return {shared_from_this(), ups_id};
+            }
+        }
+
+        return get_ups(NameTable::lookup(ups_id));
+    }
+
+    std::string Server::get_ups_description(const NameId ups_id) const {
+        {
+            std::lock_guard<std::mutex> lock(m_descriptions_mutex);
+            const auto it = m_descriptions.find(ups_id);
+            if (it != m_descriptions.end()) {
+                return it->second;
+            }
+        }
+
+        std::vector<std::string> answer = get({ "UPSDESC", NameTable::lookup(ups_id).c_str() });
+
+        if (answer.size() != 3) {
+            throw ClientException("Unexpected response length.");
+        }
+
+        remember_description(ups_id, answer[2]);
+        return answer[2];
+    }
+
+    void Server::remember_description(const NameId ups_id, const std::string& description) const {
+        std::lock_guard<std::mutex> lock(m_descriptions_mutex);
+        m_descriptions[ups_id] = description;
     }
 
     std::vector<UPS> Server::get_ups_list() const {
         std::vector<UPS> ups_vector;
-        const std::vector<std::vector<std::string>> result = get_var_list("UPS");;
-
-        for (auto answer_list : result) {
-            ups_vector.emplace_back(*this, answer_list.at(1), answer_list.at(2));
+        const std::vector<std::vector<std::string>> result = get_var_list("UPS");
+        const std::shared_ptr<const Server> self = shared_from_this();
+
+        ups_vector.reserve(result.size());
+        for (const auto& answer_list : result) {
+            const NameId ups_id = NameTable::intern(answer_list.at(1));
+            remember_description(ups_id, answer_list.at(2));
+            ups_vector.emplace_back(self, ups_id);
         }
 
         return ups_vector;
     }
 
     void Server::handle_error() const {
-        const int error_code = upscli_upserror(get_handle());
-        const std::string error_msg = upscli_strerror(get_handle());
+        throw_error(upscli_upserror(get_handle()), upscli_strerror(get_handle()));
+    }
+
+    void Server::throw_reply_error(const std::string& reply, const std::string& context) {
+        const std::string error = reply.size() > 4 ? reply.substr(4) : "";
+        const auto it = UPSD_ERRORS.find(error.substr(0, error.find(' ')));
+        throw_error(it == UPSD_ERRORS.end() ? -1 : it->second, context + " failed: " + error);
+    }
 
+    void Server::throw_error(const int error_code, const std::string& error_msg) {
         switch (error_code) {
             // Connection Errors
             case UPSCLI_ERR_NOSUCHHOST: // 2
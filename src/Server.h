@@ -23,29 +23,170 @@
 
 // Unused import fixes missing dependency for uint16_t when using upsclient.h methods.
 #include <cstdint>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <upsclient.h>
 
+#include "NameTable.h"
+
 
 namespace nut {
 
     class UPS;
 
-    class Server {
+    /**
+     * Transport security used by connect().
+     */
+    enum class SSLMode {
+        // Never send STARTTLS.
+        PLAIN,
+        // Attempt STARTTLS and fall back to plain text if upsd refuses it.
+        TRY,
+        // Fail to connect unless TLS is established.
+        REQUIRE
+    };
+
+    struct ConnectionStats {
+        // Wall time of the last connect(), including TCP setup and any STARTTLS handshake.
+        std::chrono::microseconds last_connect_time{0};
+        std::chrono::microseconds total_connect_time{0};
+        uint32_t connect_count = 0;
+        // Whether the current connection is encrypted.
+        bool tls_active = false;
+        // Whether the last connect() skipped STARTTLS because upsd recently refused it, see
+        // Server::set_remember_tls_refusal().
+        bool tls_skipped = false;
+    };
+
+    /**
+     * Connection to a NUT server. Always owned by a shared pointer, create with Server::create(), so UPS handles
+     * can keep it alive. Requests are serialized on the single connection, so a Server and every UPS handle on it
+     * may be used from several threads; concurrent requests wait for each other rather than run in parallel.
+     */
+    class Server : public std::enable_shared_from_this<Server> {
     private:
+        // Restricts construction to create() while still allowing std::make_shared.
+        struct Passkey {
+            explicit Passkey() = default;
+        };
+
+        // Held for every request and connection change, recursive so compound operations can hold it throughout.
+        mutable std::recursive_mutex m_connection_mutex;
         UPSCONN_t m_connection;
         std::string m_hostname;
         int m_port;
+        SSLMode m_ssl_mode = SSLMode::TRY;
+        bool m_verify_certificate = false;
+        bool m_remember_tls_refusal = false;
+        // Timeouts of the last connect() and set_io_timeout(), applied again by reconnect().
+        std::chrono::milliseconds m_connect_timeout{0};
+        std::chrono::milliseconds m_io_timeout{0};
+        // Credentials of authenticate(), sent again after reconnect().
+        std::string m_username;
+        std::string m_password;
+        ConnectionStats m_stats;
+        // Descriptions of UPS seen by get_ups()/get_ups_list(), keyed by interned name.
+        mutable std::mutex m_descriptions_mutex;
+        mutable std::unordered_map<NameId, std::string> m_descriptions;
+
+        [[nodiscard]] std::vector<std::string> get(std::vector<const char*> query) const;
+        [[nodiscard]] std::vector<std::vector<std::string>> list(std::vector<const char*> query) const;
+        [[nodiscard]] std::vector<std::vector<std::vector<std::string>>> pipeline(const std::vector<std::string>& requests) const;
+        std::string command(const std::string& request, const std::string& context) const;
+        [[nodiscard]] std::string read_line() const;
+        void log_in(const std::string& username, const std::string& password) const;
+        void remember_description(NameId ups_id, const std::string& description) const;
+        [[noreturn]] static void throw_error(int error_code, const std::string& error_msg);
+        [[noreturn]] static void throw_reply_error(const std::string& reply, const std::string& context);
 
     public:
-        explicit Server(std::string  hostname = "localhost", int port = 3493);
+        Server(Passkey, std::string hostname, int port);
         ~Server();
 
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        /**
+         * Create Server owned by a shared pointer. This is the only way to construct a Server.
+         * @param hostname hostname of NUT server
+         * @param port port of NUT server
+         * @return shared pointer to new Server
+         */
+        [[nodiscard]] static std::shared_ptr<Server> create(std::string hostname = "localhost", int port = 3493);
+
+        /**
+         * Initialize SSL support of libupsclient. Must be called before the first connect() of the process to
+         * enable certificate verification.
+         * @param cert_path path of CA certificate directory or database
+         * @param verify_certificate require valid server certificates for all connections
+         * @param cert_name name of client certificate (NSS builds only)
+         * @param cert_password password of client certificate (NSS builds only)
+         * @throws ClientException
+         */
+        static void init_ssl(const std::string& cert_path, bool verify_certificate = true,
+                             const std::string& cert_name = "", const std::string& cert_password = "");
+
+        /**
+         * Set transport security for subsequent connects. Defaults to SSLMode::TRY.
+         * @param ssl_mode SSLMode to use
+         * @param verify_certificate verify certificate of this server
+         */
+        void set_ssl_mode(SSLMode ssl_mode, bool verify_certificate = false);
+
+        /**
+         * Opt in to skipping STARTTLS in SSLMode::TRY for hosts that refused it within the last few minutes.
+         * Refusals are shared by every Server in the process that opted in. This trades a possible downgrade
+         * for one less round trip per connect, so it is never applied while certificate verification is on.
+         * @param enabled whether to use and record refusals
+         */
+        void set_remember_tls_refusal(bool enabled);
+
+        /**
+         * Get configured transport security.
+         * @return SSLMode
+         */
+        [[nodiscard]] SSLMode get_ssl_mode() const {
+            std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+            return m_ssl_mode;
+        }
+
         /**
          * Initialize connection to NUT Server.
+         * Every connect performs a full TLS handshake when TLS is used: libupsclient negotiates inside
+         * upscli_connect() and does not expose its session, so TLS session resumption is not provided.
+         * See set_remember_tls_refusal() for skipping STARTTLS on hosts that refuse it.
+         * @param timeout maximum time to wait for the TCP connection, zero waits indefinitely
          */
-        void connect();
+        void connect(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+        /**
+         * Limit how long any single send or receive on the current connection may block. A request that times
+         * out throws ConnectionException and leaves the connection unusable until reconnect().
+         * @param timeout maximum blocking time, zero waits indefinitely
+         * @throws ConnectionException
+         */
+        void set_io_timeout(std::chrono::milliseconds timeout);
+
+        /**
+         * Drop current connection and connect again with the timeouts last given to connect() and
+         * set_io_timeout(). UPS handles stay valid across reconnects, and credentials given to authenticate() are
+         * sent again.
+         */
+        void reconnect();
+
+        /**
+         * Send USERNAME and PASSWORD, which upsd requires before SET VAR. upsd only checks the credentials at the
+         * first privileged command, so a wrong password surfaces there as AuthenticationException.
+         * @param username upsd user, may not contain whitespace or control characters
+         * @param password password of user, may not contain line breaks
+         * @throws NUTException, AuthenticationException if the session is already logged in
+         */
+        void authenticate(const std::string& username, const std::string& password);
 
         /**
          * Get variable value from specified UPS.
@@ -82,6 +223,63 @@ namespace nut {
          */
         [[nodiscard]] std::vector<std::vector<std::string>> get_var_list(const std::string& ups_name, const std::string& var_key) const;
 
+        /**
+         * Query list which requires both a UPS and a variable name (e.g. ENUM, RANGE).
+         * @param ups_name string name of UPS
+         * @param var_name string name of variable
+         * @param list_key string list type to be queried
+         * @return vector of strings containing return values.
+         * @throws NUTException
+         */
+        [[nodiscard]] std::vector<std::vector<std::string>> get_var_sublist(const std::string& ups_name, const std::string& var_name, const std::string& list_key) const;
+
+        /**
+         * Get type tokens of a variable (e.g. RW, ENUM, RANGE, STRING:n, NUMBER).
+         * @param ups_name Name of UPS to query
+         * @param var_name Variable to be queried
+         * @return vector of type tokens
+         * @throws NUTException
+         */
+        [[nodiscard]] std::vector<std::string> get_var_type(const std::string& ups_name, const std::string& var_name) const;
+
+        /**
+         * Get type tokens of several variables, sending the GET TYPE requests in batches instead of waiting for
+         * each reply in turn.
+         * @param ups_name Name of UPS to query
+         * @param var_names Variables to be queried
+         * @return vector of type tokens per variable, in the order of var_names
+         * @throws NUTException
+         */
+        [[nodiscard]] std::vector<std::vector<std::string>> get_var_types(const std::string& ups_name, const std::vector<std::string>& var_names) const;
+
+        /**
+         * Query several lists which require both a UPS and a variable name, sending the requests in batches
+         * instead of waiting for each list in turn.
+         * @param ups_name string name of UPS
+         * @param queries pairs of list type (e.g. ENUM, RANGE) and variable name
+         * @return rows of each list, in the order of queries
+         * @throws NUTException
+         */
+        [[nodiscard]] std::vector<std::vector<std::vector<std::string>>> get_var_sublists(const std::string& ups_name, const std::vector<std::pair<std::string, std::string>>& queries) const;
+
+        /**
+         * Get description of a variable.
+         * @param ups_name Name of UPS to query
+         * @param var_name Variable to be queried
+         * @return string description
+         * @throws NUTException
+         */
+        [[nodiscard]] std::string get_var_description(const std::string& ups_name, const std::string& var_name) const;
+
+        /**
+         * Set value of a writable variable. upsd rejects the request unless authenticate() was called first.
+         * @param ups_name Name of UPS, may not contain whitespace or control characters
+         * @param var_name Variable to be set, may not contain whitespace or control characters
+         * @param value New value of variable, may not contain line breaks
+         * @throws NUTException, VariableException if upsd rejects the value
+         */
+        void set_var(const std::string& ups_name, const std::string& var_name, const std::string& value) const;
+
         /**
          * Get UPS object for a specified name.
          * @param ups_name string name of UPS
@@ -90,9 +288,27 @@ namespace nut {
          */
         [[nodiscard]] UPS get_ups(const std::string& ups_name) const;
 
+        /**
+         * Get UPS object for an interned name. No request is sent if the UPS was already returned by get_ups() or
+         * get_ups_list() of this Server.
+         * @param ups_id NameId of UPS name
+         * @return UPS object for name.
+         * @throws NUTException
+         */
+        [[nodiscard]] UPS get_ups(NameId ups_id) const;
+
+        /**
+         * Get description of UPS, querying the server only if it is not already known.
+         * @param ups_id NameId of UPS name
+         * @return string description
+         * @throws NUTException
+         */
+        [[nodiscard]] std::string get_ups_description(NameId ups_id) const;
+
         /**
          * Get list of UPS connected to this NUT server.
          * @return vector of UPS objects
+         * @throws NUTException
          */
         [[nodiscard]] std::vector<UPS> get_ups_list() const;
 
@@ -119,7 +335,17 @@ namespace nut {
         }
 
         /**
-         * Get instance of UPSCONN_t object with constant casting.
+         * Get connect timing and TLS state of this Server.
+         * @return copy of ConnectionStats
+         */
+        [[nodiscard]] ConnectionStats get_connection_stats() const {
+            std::lock_guard<std::recursive_mutex> lock(m_connection_mutex);
+            return m_stats;
+        }
+
+        /**
+         * Get instance of UPSCONN_t object with constant casting. Requests sent through the handle are not
+         * serialized with those of the Server.
          * @return const_cast of UPSCONN_t.
          */
         [[nodiscard]] UPSCONN_t* get_handle() const {
@@ -25,48 +25,62 @@
 #include <utility>
 
 #include "Server.h"
+#include "VariableCache.h"
 
 namespace nut {
 
-    UPS::UPS(const Server& server, std::string ups_name, std::string ups_description) :
-        m_server(server),
-        m_ups_name(std::move(ups_name)),
-        m_ups_description(std::move(ups_description))
+    UPS::UPS(std::shared_ptr<const Server> server, const NameId name_id) :
+        m_server(std::move(server)),
+        m_name_id(name_id)
+    {}
+
+    UPS::UPS(std::shared_ptr<const Server> server, const std::string& ups_name) :
+        UPS(std::move(server), NameTable::intern(ups_name))
     {}
 
     UPS::~UPS() = default;
 
     const std::string& UPS::get_name() const {
-        return m_ups_name;
+        return NameTable::lookup(m_name_id);
     }
 
-    const std::string& UPS::get_description() const {
-        return m_ups_description;
+    std::string UPS::get_description() const {
+        return m_server->get_ups_description(m_name_id);
     }
 
     double UPS::get_charge() const {
-        return m_server.get_var_double(get_name(), "battery.charge");
+        return m_server->get_var_double(get_name(), "battery.charge");
     }
 
     double UPS::get_load() const {
-        return m_server.get_var_double(get_name(), "ups.load");
+        return m_server->get_var_double(get_name(), "ups.load");
     }
 
     std::string UPS::get_model() const {
-        return m_server.get_var(get_name(), "ups.model");
+        return m_server->get_var(get_name(), "ups.model");
     }
 
     std::string UPS::get_serial() const {
-        return m_server.get_var(get_name(), "device.serial");
+        return m_server->get_var(get_name(), "device.serial");
     }
 
     std::string UPS::get_variable(const std::string& var_name) const {
-        return m_server.get_var(get_name(), var_name);
+        return m_server->get_var(get_name(), var_name);
+    }
+
+    void UPS::set_variable(const std::string& var_name, const std::string& value) const {
+        m_server->set_var(get_name(), var_name, value);
+    }
+
+    VariableCache UPS::get_variable_cache() const {
+        VariableCache cache(*this);
+        cache.refresh();
+        return cache;
     }
 
     std::vector<std::string> UPS::get_command_list() const {
         std::vector<std::string> cmds;
-        std::vector<std::vector<std::string>> raw_list = m_server.get_var_list(get_name(), "CMD");
+        std::vector<std::vector<std::string>> raw_list = m_server->get_var_list(get_name(), "CMD");
 
         for (std::vector<std::string>& answer_list : raw_list) {
             cmds.emplace_back(answer_list.at(2));
@@ -77,7 +91,7 @@ namespace nut {
 
     std::vector<std::string> UPS::get_variables_list() const {
         std::vector<std::string> vars;
-        std::vector<std::vector<std::string>> raw_list = m_server.get_var_list(get_name(), "VAR");
+        std::vector<std::vector<std::string>> raw_list = m_server->get_var_list(get_name(), "VAR");
 
         for (std::vector<std::string>& answer_list : raw_list) {
             vars.emplace_back(answer_list.at(2));
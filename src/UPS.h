@@ -21,22 +21,42 @@
 #ifndef NUT_PLUS_PLUS_UPS_H
 #define NUT_PLUS_PLUS_UPS_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "NameTable.h"
+
 namespace nut {
 
     class Server;
+    class VariableCache;
 
     class UPS {
         private:
-            const Server& m_server;
-            const std::string m_ups_name;
-            const std::string m_ups_description;
+            std::shared_ptr<const Server> m_server;
+            NameId m_name_id;
         public:
-            UPS(const Server& server, std::string ups_name, std::string ups_description);
+            UPS(std::shared_ptr<const Server> server, NameId name_id);
+            UPS(std::shared_ptr<const Server> server, const std::string& ups_name);
             ~UPS();
 
+            /**
+             * Get interned id of UPS name.
+             * @return NameId of name
+             */
+            [[nodiscard]] NameId get_id() const {
+                return m_name_id;
+            }
+
+            /**
+             * Get server this UPS is attached to.
+             * @return shared pointer to Server
+             */
+            [[nodiscard]] const std::shared_ptr<const Server>& get_server() const {
+                return m_server;
+            }
+
             /**
              * Get name of UPS.
              * @return string name
@@ -44,10 +64,11 @@ namespace nut {
             [[nodiscard]] const std::string& get_name() const;
 
             /**
-             * Get description of UPS.
+             * Get description of UPS. Served from the Server's cache when the handle came from get_ups() or
+             * get_ups_list().
              * @return string description
              */
-            [[nodiscard]] const std::string& get_description() const;
+            [[nodiscard]] std::string get_description() const;
 
             /**
              * Get current charge of UPS.
@@ -91,6 +112,19 @@ namespace nut {
              * @return string value of variable
              */
             [[nodiscard]] std::string get_variable(const std::string& var_name) const;
+
+            /**
+             * Set value of specified variable without client-side validation.
+             * @param var_name name of variable to set
+             * @param value new value of variable
+             */
+            void set_variable(const std::string& var_name, const std::string& value) const;
+
+            /**
+             * Fetch metadata of all writable variables for local validation of writes.
+             * @return populated VariableCache for this UPS
+             */
+            [[nodiscard]] VariableCache get_variable_cache() const;
     };
 } // nut
 
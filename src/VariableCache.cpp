@@ -0,0 +1,220 @@
+// Caches metadata of writable UPS variables for client-side validation.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "VariableCache.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "Server.h"
+#include "exceptions/ClientException.h"
+#include "exceptions/VariableException.h"
+
+namespace nut {
+
+    namespace {
+        bool parse_number(const std::string& value, double& out) {
+            if (value.empty()) {
+                return false;
+            }
+
+            try {
+                size_t consumed;
+                out = std::stod(value, &consumed);
+                return consumed == value.size();
+            } catch (const std::logic_error&) {
+                return false;
+            }
+        }
+    }
+
+    VariableCache::VariableCache(UPS ups) :
+        m_ups(std::move(ups))
+    {}
+
+    VariableCache::~VariableCache() = default;
+
+    void VariableCache::refresh() {
+        const Server& server = *m_ups.get_server();
+        const std::string& ups_name = m_ups.get_name();
+        std::vector<std::string> names;
+        std::vector<VariableInfo> info;
+
+        for (const std::vector<std::string>& answer_list : server.get_var_list(ups_name, "RW")) {
+            names.emplace_back(answer_list.at(2));
+        }
+
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        info.resize(names.size());
+
+        const std::vector<std::vector<std::string>> types = server.get_var_types(ups_name, names);
+        // List type and variable of every ENUM and RANGE list to fetch, with the index of the variable.
+        std::vector<std::pair<std::string, std::string>> lists;
+        std::vector<size_t> list_owners;
+
+        for (size_t i = 0; i < names.size(); ++i) {
+            VariableInfo& var_info = info[i];
+
+            for (const std::string& token : types[i]) {
+                if (token == "RW") {
+                    var_info.flags |= VariableInfo::RW;
+                } else if (token == "ENUM") {
+                    var_info.flags |= VariableInfo::ENUM;
+                } else if (token == "RANGE") {
+                    var_info.flags |= VariableInfo::RANGE;
+                } else if (token == "NUMBER") {
+                    var_info.flags |= VariableInfo::NUMBER;
+                } else if (token.rfind("STRING", 0) == 0) {
+                    var_info.flags |= VariableInfo::STRING;
+
+                    const size_t separator = token.find(':');
+                    if (separator != std::string::npos) {
+                        try {
+                            var_info.max_length = static_cast<uint16_t>(std::stoul(token.substr(separator + 1)));
+                        } catch (const std::logic_error& e) {
+                            throw ClientException(e.what());
+                        }
+                    }
+                }
+            }
+
+            if (var_info.has(VariableInfo::ENUM)) {
+                lists.emplace_back("ENUM", names[i]);
+                list_owners.push_back(i);
+            }
+
+            if (var_info.has(VariableInfo::RANGE)) {
+                lists.emplace_back("RANGE", names[i]);
+                list_owners.push_back(i);
+            }
+        }
+
+        const std::vector<std::vector<std::vector<std::string>>> rows = server.get_var_sublists(ups_name, lists);
+
+        for (size_t j = 0; j < lists.size(); ++j) {
+            VariableInfo& var_info = info[list_owners[j]];
+
+            for (const std::vector<std::string>& answer_list : rows[j]) {
+                if (lists[j].first == "ENUM") {
+                    var_info.enum_values.emplace_back(answer_list.at(3));
+                    continue;
+                }
+
+                double min;
+                double max;
+                if (!parse_number(answer_list.at(3), min) || !parse_number(answer_list.at(4), max)) {
+                    throw ClientException("Invalid range for variable " + lists[j].second + ".");
+                }
+                var_info.ranges.emplace_back(min, max);
+            }
+        }
+
+        m_names = std::move(names);
+        m_info = std::move(info);
+        m_described.assign(m_names.size(), false);
+    }
+
+    const VariableInfo* VariableCache::find(const std::string& var_name) const {
+        const auto it = std::lower_bound(m_names.begin(), m_names.end(), var_name);
+
+        if (it == m_names.end() || *it != var_name) {
+            return nullptr;
+        }
+
+        return &m_info[it - m_names.begin()];
+    }
+
+    bool VariableCache::contains(const std::string& var_name) const {
+        return find(var_name) != nullptr;
+    }
+
+    const VariableInfo& VariableCache::get_info(const std::string& var_name) const {
+        const VariableInfo* var_info = find(var_name);
+
+        if (var_info == nullptr) {
+            throw VariableException("Variable " + var_name + " is unknown or read-only.");
+        }
+
+        const size_t index = var_info - m_info.data();
+        if (!m_described[index]) {
+            m_info[index].description = m_ups.get_server()->get_var_description(m_ups.get_name(), var_name);
+            m_described[index] = true;
+        }
+
+        return *var_info;
+    }
+
+    std::string VariableCache::check(const std::string& var_name, const std::string& value) const {
+        const VariableInfo* var_info = find(var_name);
+
+        if (var_info == nullptr) {
+            return "Variable " + var_name + " is unknown or read-only.";
+        }
+
+        if (value.find_first_of("\r\n") != std::string::npos) {
+            return "Variable value may not contain line breaks.";
+        }
+
+        if (var_info->has(VariableInfo::STRING) && var_info->max_length != 0 && value.size() > var_info->max_length) {
+            return "Value for " + var_name + " exceeds maximum length of " + std::to_string(var_info->max_length) + ".";
+        }
+
+        if (var_info->has(VariableInfo::ENUM) &&
+            std::find(var_info->enum_values.begin(), var_info->enum_values.end(), value) == var_info->enum_values.end()) {
+            return "Value for " + var_name + " is not one of the enumerated values.";
+        }
+
+        if (var_info->has(VariableInfo::RANGE) || var_info->has(VariableInfo::NUMBER)) {
+            double number;
+            if (!parse_number(value, number)) {
+                return "Value for " + var_name + " is not a number.";
+            }
+
+            if (var_info->has(VariableInfo::RANGE) && !var_info->ranges.empty() &&
+                std::none_of(var_info->ranges.begin(), var_info->ranges.end(),
+                    [number](const std::pair<double, double>& range) {
+                        return number >= range.first && number <= range.second;
+                    })) {
+                return "Value for " + var_name + " is out of range.";
+            }
+        }
+
+        return {};
+    }
+
+    bool VariableCache::is_valid(const std::string& var_name, const std::string& value) const {
+        return check(var_name, value).empty();
+    }
+
+    void VariableCache::validate(const std::string& var_name, const std::string& value) const {
+        const std::string error = check(var_name, value);
+
+        if (!error.empty()) {
+            throw VariableException(error);
+        }
+    }
+
+    void VariableCache::set_variable(const std::string& var_name, const std::string& value) const {
+        validate(var_name, value);
+        m_ups.set_variable(var_name, value);
+    }
+} // nut
@@ -0,0 +1,137 @@
+// Caches metadata of writable UPS variables for client-side validation.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef NUT_PLUS_PLUS_VARIABLECACHE_H
+#define NUT_PLUS_PLUS_VARIABLECACHE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "UPS.h"
+
+namespace nut {
+
+    /**
+     * Metadata of a single writable variable as reported by GET TYPE, LIST ENUM and LIST RANGE. The description
+     * is not needed for validation and is only fetched with GET DESC by VariableCache::get_info().
+     */
+    struct VariableInfo {
+        enum Flag : uint8_t {
+            RW = 1 << 0,
+            ENUM = 1 << 1,
+            RANGE = 1 << 2,
+            STRING = 1 << 3,
+            NUMBER = 1 << 4
+        };
+
+        uint8_t flags = 0;
+        uint16_t max_length = 0;
+        std::string description;
+        std::vector<std::string> enum_values;
+        std::vector<std::pair<double, double>> ranges;
+
+        [[nodiscard]] bool has(const Flag flag) const {
+            return (flags & flag) != 0;
+        }
+    };
+
+    class VariableCache {
+        private:
+            UPS m_ups;
+            // Sorted by name, m_info[i] describes m_names[i].
+            std::vector<std::string> m_names;
+            mutable std::vector<VariableInfo> m_info;
+            // Whether m_info[i].description has been fetched.
+            mutable std::vector<bool> m_described;
+
+            [[nodiscard]] const VariableInfo* find(const std::string& var_name) const;
+            [[nodiscard]] std::string check(const std::string& var_name, const std::string& value) const;
+        public:
+            explicit VariableCache(UPS ups);
+            ~VariableCache();
+
+            /**
+             * Fetch metadata of every writable variable of the UPS, replacing any cached data. Takes three round
+             * trips however many variables there are: LIST RW, then every GET TYPE, then every LIST ENUM and
+             * LIST RANGE, each group sent in batches.
+             * @throws NUTException
+             */
+            void refresh();
+
+            /**
+             * Get UPS this cache describes.
+             * @return UPS handle
+             */
+            [[nodiscard]] const UPS& get_ups() const {
+                return m_ups;
+            }
+
+            /**
+             * Get names of all cached writable variables.
+             * @return sorted vector of variable names.
+             */
+            [[nodiscard]] const std::vector<std::string>& get_variables() const {
+                return m_names;
+            }
+
+            /**
+             * Check whether variable is known to be writable.
+             * @param var_name name of variable
+             * @return true if variable is cached
+             */
+            [[nodiscard]] bool contains(const std::string& var_name) const;
+
+            /**
+             * Get cached metadata of variable. The description is fetched from the server on first access.
+             * @param var_name name of variable
+             * @return metadata of variable
+             * @throws VariableException, NUTException
+             */
+            [[nodiscard]] const VariableInfo& get_info(const std::string& var_name) const;
+
+            /**
+             * Check proposed value against cached metadata without contacting the server.
+             * @param var_name name of variable
+             * @param value proposed value
+             * @return true if value would be accepted
+             */
+            [[nodiscard]] bool is_valid(const std::string& var_name, const std::string& value) const;
+
+            /**
+             * Check proposed value against cached metadata without contacting the server.
+             * @param var_name name of variable
+             * @param value proposed value
+             * @throws VariableException
+             */
+            void validate(const std::string& var_name, const std::string& value) const;
+
+            /**
+             * Validate value locally, then set it on the server.
+             * @param var_name name of variable
+             * @param value new value
+             * @throws NUTException
+             */
+            void set_variable(const std::string& var_name, const std::string& value) const;
+    };
+} // nut
+
+#endif //NUT_PLUS_PLUS_VARIABLECACHE_H
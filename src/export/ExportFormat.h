@@ -0,0 +1,179 @@
+// Wire format shared by ExportWriter and ExportReader.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// A stream is a sequence of segments. Each segment is self-contained and starts with a header; ids and
+// values from earlier segments are forgotten.
+//
+//   header      "NUTX" version:u8
+//   DEFINE_UPS  0x01 id:varint name:string
+//   DEFINE_VAR  0x02 id:varint name:string
+//   FRAME       0x03 time_delta_ms:zigzag count:varint change*
+//   change      ups_id:varint var_id:varint kind:u8 payload
+//     STRING    value:string
+//     NUMBER    scale:u8 mantissa:zigzag       value = mantissa / 10^scale
+//     DELTA     delta:zigzag                   mantissa += delta, scale unchanged
+//     REMOVED   (no payload)
+//   string      length:varint bytes
+
+#ifndef NUT_PLUS_PLUS_EXPORTFORMAT_H
+#define NUT_PLUS_PLUS_EXPORTFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace nut::export_format {
+
+    constexpr char MAGIC[4] = { 'N', 'U', 'T', 'X' };
+    constexpr uint8_t VERSION = 1;
+
+    enum Record : uint8_t {
+        DEFINE_UPS = 0x01,
+        DEFINE_VAR = 0x02,
+        FRAME = 0x03
+    };
+
+    enum Change : uint8_t {
+        STRING = 0,
+        NUMBER = 1,
+        DELTA = 2,
+        REMOVED = 3
+    };
+
+    // Decimal values with more fraction digits than this are sent as strings.
+    constexpr uint8_t MAX_SCALE = 9;
+
+    inline uint64_t zigzag_encode(const int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    inline int64_t zigzag_decode(const uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    inline void put_varint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    inline void put_string(std::string& out, const std::string& value) {
+        put_varint(out, value.size());
+        out += value;
+    }
+
+    /**
+     * Read varint at position. Returns false without advancing if data ends first.
+     */
+    inline bool get_varint(const std::string& in, size_t& position, uint64_t& value) {
+        value = 0;
+        for (size_t i = position, shift = 0; i < in.size() && shift < 64; ++i, shift += 7) {
+            const auto byte = static_cast<uint8_t>(in[i]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                position = i + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline bool get_string(const std::string& in, size_t& position, std::string& value) {
+        size_t cursor = position;
+        uint64_t length;
+        if (!get_varint(in, cursor, length) || in.size() - cursor < length) {
+            return false;
+        }
+        value.assign(in, cursor, length);
+        position = cursor + length;
+        return true;
+    }
+
+    /**
+     * Parse canonical decimal text (e.g. "230.0", "-12", "0.25") into mantissa and scale. Text that would not
+     * be reproduced exactly by format_decimal(), such as "007" or "+1", is rejected.
+     */
+    inline bool parse_decimal(const std::string& text, int64_t& mantissa, uint8_t& scale) {
+        size_t i = 0;
+        const bool negative = !text.empty() && text[0] == '-';
+        if (negative) {
+            ++i;
+        }
+
+        const size_t integer_start = i;
+        while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+            ++i;
+        }
+        const size_t integer_digits = i - integer_start;
+        if (integer_digits == 0 || (integer_digits > 1 && text[integer_start] == '0')) {
+            return false;
+        }
+
+        size_t fraction_digits = 0;
+        if (i < text.size() && text[i] == '.') {
+            ++i;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                ++i;
+                ++fraction_digits;
+            }
+            if (fraction_digits == 0) {
+                return false;
+            }
+        }
+
+        if (i != text.size() || fraction_digits > MAX_SCALE || integer_digits + fraction_digits > 18) {
+            return false;
+        }
+
+        int64_t value = 0;
+        for (const char c : text) {
+            if (c >= '0' && c <= '9') {
+                value = value * 10 + (c - '0');
+            }
+        }
+
+        // "-0" and "-0.0" would come back without their sign.
+        if (negative && value == 0) {
+            return false;
+        }
+
+        mantissa = negative ? -value : value;
+        scale = static_cast<uint8_t>(fraction_digits);
+        return true;
+    }
+
+    inline std::string format_decimal(const int64_t mantissa, const uint8_t scale) {
+        const bool negative = mantissa < 0;
+        std::string digits = std::to_string(negative ? -static_cast<uint64_t>(mantissa) : static_cast<uint64_t>(mantissa));
+
+        if (scale > 0) {
+            if (digits.size() <= scale) {
+                digits.insert(0, scale + 1 - digits.size(), '0');
+            }
+            digits.insert(digits.size() - scale, 1, '.');
+        }
+
+        return negative ? "-" + digits : digits;
+    }
+} // nut::export_format
+
+#endif //NUT_PLUS_PLUS_EXPORTFORMAT_H
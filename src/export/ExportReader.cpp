@@ -0,0 +1,189 @@
+// Decodes the binary change stream produced by ExportWriter.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "ExportReader.h"
+
+#include <cstring>
+
+#include "ExportFormat.h"
+#include "../exceptions/ClientException.h"
+
+namespace nut {
+
+    using namespace export_format;
+
+    ExportReader::ExportReader() = default;
+
+    ExportReader::~ExportReader() = default;
+
+    void ExportReader::feed(const char* data, const size_t size) {
+        // Drop consumed bytes once they dominate the buffer.
+        if (m_position > 4096 && m_position * 2 > m_buffer.size()) {
+            m_buffer.erase(0, m_position);
+            m_position = 0;
+        }
+        m_buffer.append(data, size);
+    }
+
+    const std::string& ExportReader::name(const std::unordered_map<uint64_t, std::string>& names, const uint64_t id) const {
+        const auto it = names.find(id);
+        if (it == names.end()) {
+            throw ClientException("Export stream references undefined id " + std::to_string(id) + ".");
+        }
+        return it->second;
+    }
+
+    bool ExportReader::read_frame(size_t& position, ExportFrame& frame) {
+        size_t cursor = position;
+        uint64_t time_delta;
+        uint64_t num_changes;
+
+        if (!get_varint(m_buffer, cursor, time_delta) || !get_varint(m_buffer, cursor, num_changes)) {
+            return false;
+        }
+
+        // Numbers are only committed once the whole frame has arrived, so a partial frame can be retried.
+        std::vector<std::pair<std::pair<uint64_t, uint64_t>, Number>> numbers;
+        std::vector<std::pair<uint64_t, uint64_t>> cleared;
+        std::vector<ExportChange> changes;
+
+        for (uint64_t i = 0; i < num_changes; ++i) {
+            uint64_t ups_id;
+            uint64_t var_id;
+            if (!get_varint(m_buffer, cursor, ups_id) || !get_varint(m_buffer, cursor, var_id) || cursor >= m_buffer.size()) {
+                return false;
+            }
+
+            const auto kind = static_cast<uint8_t>(m_buffer[cursor++]);
+            const std::pair<uint64_t, uint64_t> key(ups_id, var_id);
+            ExportChange change;
+            change.ups_name = name(m_ups_names, ups_id);
+            change.var_name = name(m_var_names, var_id);
+
+            if (kind == STRING) {
+                if (!get_string(m_buffer, cursor, change.value)) {
+                    return false;
+                }
+                cleared.push_back(key);
+            } else if (kind == NUMBER) {
+                uint64_t mantissa;
+                if (cursor >= m_buffer.size()) {
+                    return false;
+                }
+                Number number;
+                number.scale = static_cast<uint8_t>(m_buffer[cursor++]);
+                if (!get_varint(m_buffer, cursor, mantissa)) {
+                    return false;
+                }
+                if (number.scale > MAX_SCALE) {
+                    throw ClientException("Export stream contains invalid decimal scale.");
+                }
+                number.mantissa = zigzag_decode(mantissa);
+                change.value = format_decimal(number.mantissa, number.scale);
+                numbers.emplace_back(key, number);
+            } else if (kind == DELTA) {
+                uint64_t delta;
+                if (!get_varint(m_buffer, cursor, delta)) {
+                    return false;
+                }
+                const auto previous = m_numbers.find(key);
+                if (previous == m_numbers.end()) {
+                    throw ClientException("Export stream contains delta without base value for " + change.var_name + ".");
+                }
+                Number number = previous->second;
+                number.mantissa += zigzag_decode(delta);
+                change.value = format_decimal(number.mantissa, number.scale);
+                numbers.emplace_back(key, number);
+            } else if (kind == REMOVED) {
+                change.removed = true;
+                cleared.push_back(key);
+            } else {
+                throw ClientException("Export stream contains unknown change kind " + std::to_string(kind) + ".");
+            }
+
+            changes.emplace_back(std::move(change));
+        }
+
+        for (const auto& key : cleared) {
+            m_numbers.erase(key);
+        }
+        for (const auto& [key, number] : numbers) {
+            m_numbers[key] = number;
+        }
+
+        m_last_timestamp += zigzag_decode(time_delta);
+        frame.timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(m_last_timestamp));
+        frame.changes = std::move(changes);
+        position = cursor;
+        return true;
+    }
+
+    bool ExportReader::next(ExportFrame& frame) {
+        while (m_position < m_buffer.size()) {
+            size_t cursor = m_position;
+            const auto record = static_cast<uint8_t>(m_buffer[cursor]);
+
+            if (record == static_cast<uint8_t>(MAGIC[0])) {
+                if (m_buffer.size() - cursor < sizeof(MAGIC) + 1) {
+                    return false;
+                }
+                if (std::memcmp(m_buffer.data() + cursor, MAGIC, sizeof(MAGIC)) != 0) {
+                    throw ClientException("Export stream contains invalid header.");
+                }
+                if (static_cast<uint8_t>(m_buffer[cursor + sizeof(MAGIC)]) != VERSION) {
+                    throw ClientException("Unsupported export stream version.");
+                }
+
+                m_in_segment = true;
+                m_ups_names.clear();
+                m_var_names.clear();
+                m_numbers.clear();
+                m_last_timestamp = 0;
+                m_position = cursor + sizeof(MAGIC) + 1;
+                continue;
+            }
+
+            if (!m_in_segment) {
+                throw ClientException("Export stream does not start with a header.");
+            }
+
+            ++cursor;
+            if (record == DEFINE_UPS || record == DEFINE_VAR) {
+                uint64_t id;
+                std::string defined;
+                if (!get_varint(m_buffer, cursor, id) || !get_string(m_buffer, cursor, defined)) {
+                    return false;
+                }
+                (record == DEFINE_UPS ? m_ups_names : m_var_names)[id] = std::move(defined);
+                m_position = cursor;
+            } else if (record == FRAME) {
+                if (!read_frame(cursor, frame)) {
+                    return false;
+                }
+                m_position = cursor;
+                return true;
+            } else {
+                throw ClientException("Export stream contains unknown record " + std::to_string(record) + ".");
+            }
+        }
+
+        return false;
+    }
+} // nut
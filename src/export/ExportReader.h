@@ -0,0 +1,88 @@
+// Decodes the binary change stream produced by ExportWriter.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef NUT_PLUS_PLUS_EXPORTREADER_H
+#define NUT_PLUS_PLUS_EXPORTREADER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nut {
+
+    struct ExportChange {
+        std::string ups_name;
+        std::string var_name;
+        std::string value;
+        bool removed = false;
+    };
+
+    struct ExportFrame {
+        std::chrono::system_clock::time_point timestamp;
+        std::vector<ExportChange> changes;
+    };
+
+    /**
+     * Incremental decoder. Bytes may be fed in chunks of any size, as read from a socket or file.
+     */
+    class ExportReader {
+        private:
+            struct Number {
+                uint8_t scale = 0;
+                int64_t mantissa = 0;
+            };
+
+            std::string m_buffer;
+            size_t m_position = 0;
+            bool m_in_segment = false;
+            std::unordered_map<uint64_t, std::string> m_ups_names;
+            std::unordered_map<uint64_t, std::string> m_var_names;
+            std::map<std::pair<uint64_t, uint64_t>, Number> m_numbers;
+            int64_t m_last_timestamp = 0;
+
+            [[nodiscard]] const std::string& name(const std::unordered_map<uint64_t, std::string>& names, uint64_t id) const;
+            bool read_frame(size_t& position, ExportFrame& frame);
+        public:
+            ExportReader();
+            ~ExportReader();
+
+            /**
+             * Append received bytes.
+             * @param data bytes read from the stream
+             * @param size number of bytes
+             */
+            void feed(const char* data, size_t size);
+
+            /**
+             * Decode next frame from fed bytes.
+             * @param frame receives decoded frame
+             * @return false if more bytes are needed
+             * @throws ClientException on malformed data
+             */
+            bool next(ExportFrame& frame);
+    };
+} // nut
+
+#endif //NUT_PLUS_PLUS_EXPORTREADER_H
@@ -0,0 +1,164 @@
+// Destinations for the binary export stream.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "ExportSink.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utility>
+
+#include "../exceptions/ClientException.h"
+#include "../exceptions/ConnectionException.h"
+
+namespace nut {
+
+    UnixSocketSink::UnixSocketSink(std::string path, const std::chrono::milliseconds send_timeout) :
+        m_path(std::move(path)),
+        m_send_timeout(send_timeout)
+    {}
+
+    UnixSocketSink::~UnixSocketSink() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    bool UnixSocketSink::begin_frame() {
+        if (m_fd >= 0) {
+            return false;
+        }
+
+        sockaddr_un address{};
+        if (m_path.size() >= sizeof(address.sun_path)) {
+            throw ClientException("Unix socket path too long: " + m_path);
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, m_path.c_str(), m_path.size() + 1);
+
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            throw ConnectionException(std::string("socket: ") + std::strerror(errno));
+        }
+
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            const std::string error = std::strerror(errno);
+            ::close(fd);
+            throw ConnectionException("connect " + m_path + ": " + error);
+        }
+
+        timeval limit{};
+        limit.tv_sec = static_cast<time_t>(m_send_timeout.count() / 1000);
+        limit.tv_usec = static_cast<suseconds_t>(m_send_timeout.count() % 1000 * 1000);
+        if (::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit)) != 0) {
+            const std::string error = std::strerror(errno);
+            ::close(fd);
+            throw ConnectionException("setsockopt " + m_path + ": " + error);
+        }
+
+        m_fd = fd;
+        return true;
+    }
+
+    void UnixSocketSink::write(const std::string& data) {
+        size_t sent = 0;
+
+        while (sent < data.size()) {
+            const ssize_t result = ::send(m_fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                // SO_SNDTIMEO expiring reports EAGAIN: the collector stopped reading.
+                const std::string error = errno == EAGAIN || errno == EWOULDBLOCK ? "timed out" : std::strerror(errno);
+                ::close(m_fd);
+                m_fd = -1;
+                throw ConnectionException("send " + m_path + ": " + error);
+            }
+            sent += static_cast<size_t>(result);
+        }
+    }
+
+    RotatingFileSink::RotatingFileSink(std::string path, const size_t max_bytes, const size_t max_files) :
+        m_path(std::move(path)),
+        m_max_bytes(max_bytes),
+        m_max_files(max_files)
+    {}
+
+    RotatingFileSink::~RotatingFileSink() = default;
+
+    void RotatingFileSink::rotate() {
+        m_file.close();
+
+        struct stat status{};
+        if (::stat(m_path.c_str(), &status) != 0) {
+            return;
+        }
+
+        if (m_max_files == 0) {
+            std::remove(m_path.c_str());
+            return;
+        }
+
+        std::remove((m_path + "." + std::to_string(m_max_files)).c_str());
+        for (size_t i = m_max_files - 1; i > 0; --i) {
+            std::rename((m_path + "." + std::to_string(i)).c_str(), (m_path + "." + std::to_string(i + 1)).c_str());
+        }
+        std::rename(m_path.c_str(), (m_path + ".1").c_str());
+    }
+
+    bool RotatingFileSink::begin_frame() {
+        if (m_file.is_open() && m_size < m_max_bytes) {
+            return false;
+        }
+
+        // Also covers a file left by an earlier process or by a failed write: it is kept as path.1, never
+        // truncated, because a new segment cannot continue a file whose ids and values this writer never saw.
+        rotate();
+
+        m_file.open(m_path, std::ios::binary | std::ios::trunc);
+        if (!m_file) {
+            throw ClientException("Failed to open export file " + m_path + ".");
+        }
+
+        m_size = 0;
+        return true;
+    }
+
+    void RotatingFileSink::write(const std::string& data) {
+        m_file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!m_file) {
+            m_file.close();
+            throw ClientException("Failed to write export file " + m_path + ".");
+        }
+        m_size += data.size();
+    }
+
+    void RotatingFileSink::flush() {
+        if (m_file.is_open()) {
+            m_file.flush();
+        }
+    }
+} // nut
@@ -0,0 +1,107 @@
+// Destinations for the binary export stream.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef NUT_PLUS_PLUS_EXPORTSINK_H
+#define NUT_PLUS_PLUS_EXPORTSINK_H
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+namespace nut {
+
+    class ExportSink {
+        public:
+            virtual ~ExportSink() = default;
+
+            /**
+             * Called before every frame. Returns true if the frame will start a new segment (new file, new
+             * connection), in which case the writer resends the header, names and full values.
+             * @throws NUTException
+             */
+            virtual bool begin_frame() = 0;
+
+            /**
+             * Write encoded bytes of one frame.
+             * @param data encoded bytes
+             * @throws NUTException
+             */
+            virtual void write(const std::string& data) = 0;
+
+            /**
+             * Push buffered bytes to the destination.
+             */
+            virtual void flush() {}
+    };
+
+    /**
+     * Streams to a collector listening on a Unix domain socket. Reconnects on the next frame after a failure.
+     */
+    class UnixSocketSink : public ExportSink {
+        private:
+            const std::string m_path;
+            const std::chrono::milliseconds m_send_timeout;
+            int m_fd = -1;
+        public:
+            /**
+             * @param path path of the collector socket
+             * @param send_timeout longest a write may block on a collector that stops reading before the
+             *                     connection is dropped, zero waits indefinitely
+             */
+            explicit UnixSocketSink(std::string path, std::chrono::milliseconds send_timeout = std::chrono::seconds(5));
+            ~UnixSocketSink() override;
+
+            UnixSocketSink(const UnixSocketSink&) = delete;
+            UnixSocketSink& operator=(const UnixSocketSink&) = delete;
+
+            bool begin_frame() override;
+            void write(const std::string& data) override;
+    };
+
+    /**
+     * Writes to a file, rotating to path.1, path.2, ... once it grows past max_bytes. An existing file at path,
+     * from an earlier run or left after a write failure, is rotated rather than overwritten.
+     */
+    class RotatingFileSink : public ExportSink {
+        private:
+            const std::string m_path;
+            const size_t m_max_bytes;
+            const size_t m_max_files;
+            std::ofstream m_file;
+            size_t m_size = 0;
+
+            void rotate();
+        public:
+            /**
+             * @param path path of active file
+             * @param max_bytes size after which the file is rotated
+             * @param max_files number of rotated files kept besides the active one
+             */
+            RotatingFileSink(std::string path, size_t max_bytes, size_t max_files = 5);
+            ~RotatingFileSink() override;
+
+            bool begin_frame() override;
+            void write(const std::string& data) override;
+            void flush() override;
+    };
+} // nut
+
+#endif //NUT_PLUS_PLUS_EXPORTSINK_H
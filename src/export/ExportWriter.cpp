@@ -0,0 +1,165 @@
+// Encodes UPS variable snapshots as a compact binary change stream.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "ExportWriter.h"
+
+#include <utility>
+
+#include "ExportFormat.h"
+#include "../Server.h"
+#include "../UPS.h"
+#include "../exceptions/ClientException.h"
+
+namespace nut {
+
+    using namespace export_format;
+
+    ExportWriter::ExportWriter(std::unique_ptr<ExportSink> sink) :
+        m_sink(std::move(sink))
+    {
+        if (!m_sink) {
+            throw ClientException("ExportWriter requires a sink.");
+        }
+    }
+
+    ExportWriter::~ExportWriter() {
+        try {
+            flush();
+        } catch (...) {
+            // Nothing sensible to do with a failed flush during destruction.
+        }
+    }
+
+    void ExportWriter::reset_segment() {
+        m_ups_ids.clear();
+        m_var_ids.clear();
+        m_values.clear();
+        m_last_timestamp = 0;
+
+        m_buffer.append(MAGIC, sizeof(MAGIC));
+        m_buffer += static_cast<char>(VERSION);
+    }
+
+    uint32_t ExportWriter::define(std::unordered_map<std::string, uint32_t>& ids, const uint8_t record, const std::string& name) {
+        const auto it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+
+        const auto id = static_cast<uint32_t>(ids.size());
+        ids.emplace(name, id);
+
+        m_buffer += static_cast<char>(record);
+        put_varint(m_buffer, id);
+        put_string(m_buffer, name);
+        return id;
+    }
+
+    void ExportWriter::write(const std::string& ups_name, const std::vector<std::vector<std::string>>& var_list,
+                             const std::chrono::system_clock::time_point time) {
+        m_buffer.clear();
+        if (m_sink->begin_frame()) {
+            reset_segment();
+        }
+
+        const uint32_t ups_id = define(m_ups_ids, DEFINE_UPS, ups_name);
+        if (ups_id >= m_values.size()) {
+            m_values.resize(ups_id + 1);
+        }
+        std::unordered_map<uint32_t, Value>& known = m_values[ups_id];
+        const uint32_t generation = ++m_generation;
+
+        std::string changes;
+        uint64_t num_changes = 0;
+
+        for (const std::vector<std::string>& answer_list : var_list) {
+            const std::string& value = answer_list.at(3);
+            const uint32_t var_id = define(m_var_ids, DEFINE_VAR, answer_list.at(2));
+
+            const auto previous = known.find(var_id);
+            Value current;
+            current.generation = generation;
+            current.numeric = parse_decimal(value, current.mantissa, current.scale);
+
+            if (previous != known.end() && previous->second.numeric == current.numeric &&
+                (current.numeric
+                    ? previous->second.scale == current.scale && previous->second.mantissa == current.mantissa
+                    : previous->second.text == value)) {
+                previous->second.generation = generation;
+                continue;
+            }
+
+            put_varint(changes, ups_id);
+            put_varint(changes, var_id);
+
+            if (!current.numeric) {
+                changes += static_cast<char>(STRING);
+                put_string(changes, value);
+                current.text = value;
+            } else if (previous != known.end() && previous->second.numeric && previous->second.scale == current.scale) {
+                changes += static_cast<char>(DELTA);
+                put_varint(changes, zigzag_encode(current.mantissa - previous->second.mantissa));
+            } else {
+                changes += static_cast<char>(NUMBER);
+                changes += static_cast<char>(current.scale);
+                put_varint(changes, zigzag_encode(current.mantissa));
+            }
+
+            known[var_id] = std::move(current);
+            ++num_changes;
+        }
+
+        for (auto it = known.begin(); it != known.end();) {
+            if (it->second.generation == generation) {
+                ++it;
+                continue;
+            }
+
+            put_varint(changes, ups_id);
+            put_varint(changes, it->first);
+            changes += static_cast<char>(REMOVED);
+            ++num_changes;
+            it = known.erase(it);
+        }
+
+        if (num_changes > 0) {
+            const int64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+
+            m_buffer += static_cast<char>(FRAME);
+            put_varint(m_buffer, zigzag_encode(timestamp - m_last_timestamp));
+            put_varint(m_buffer, num_changes);
+            m_buffer += changes;
+            m_last_timestamp = timestamp;
+        }
+
+        if (!m_buffer.empty()) {
+            m_sink->write(m_buffer);
+            m_bytes_written += m_buffer.size();
+        }
+    }
+
+    void ExportWriter::write(const UPS& ups) {
+        write(ups.get_name(), ups.get_server()->get_var_list(ups.get_name(), "VAR"));
+    }
+
+    void ExportWriter::flush() {
+        m_sink->flush();
+    }
+} // nut
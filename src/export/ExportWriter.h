@@ -0,0 +1,99 @@
+// Encodes UPS variable snapshots as a compact binary change stream.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef NUT_PLUS_PLUS_EXPORTWRITER_H
+#define NUT_PLUS_PLUS_EXPORTWRITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ExportSink.h"
+
+namespace nut {
+
+    class UPS;
+
+    class ExportWriter {
+        private:
+            struct Value {
+                uint32_t generation = 0;
+                bool numeric = false;
+                uint8_t scale = 0;
+                int64_t mantissa = 0;
+                std::string text;
+            };
+
+            std::unique_ptr<ExportSink> m_sink;
+            std::unordered_map<std::string, uint32_t> m_ups_ids;
+            std::unordered_map<std::string, uint32_t> m_var_ids;
+            // Last value sent per UPS id, keyed by variable id.
+            std::vector<std::unordered_map<uint32_t, Value>> m_values;
+            uint32_t m_generation = 0;
+            int64_t m_last_timestamp = 0;
+            uint64_t m_bytes_written = 0;
+            std::string m_buffer;
+
+            void reset_segment();
+            uint32_t define(std::unordered_map<std::string, uint32_t>& ids, uint8_t record, const std::string& name);
+        public:
+            explicit ExportWriter(std::unique_ptr<ExportSink> sink);
+            ~ExportWriter();
+
+            ExportWriter(const ExportWriter&) = delete;
+            ExportWriter& operator=(const ExportWriter&) = delete;
+
+            /**
+             * Send values that changed since the previous snapshot of this UPS. Variables missing from the
+             * snapshot are sent as removed. Nothing is written if no value changed.
+             * @param ups_name name of UPS
+             * @param var_list result of Server::get_var_list(ups_name, "VAR")
+             * @param time time the snapshot was taken
+             * @throws NUTException
+             */
+            void write(const std::string& ups_name, const std::vector<std::vector<std::string>>& var_list,
+                       std::chrono::system_clock::time_point time = std::chrono::system_clock::now());
+
+            /**
+             * Poll all variables of UPS and send changed values.
+             * @param ups UPS to poll
+             * @throws NUTException
+             */
+            void write(const UPS& ups);
+
+            /**
+             * Push buffered bytes to the sink.
+             */
+            void flush();
+
+            /**
+             * Get total bytes handed to the sink.
+             * @return uint64_t byte count
+             */
+            [[nodiscard]] uint64_t get_bytes_written() const {
+                return m_bytes_written;
+            }
+    };
+} // nut
+
+#endif //NUT_PLUS_PLUS_EXPORTWRITER_H
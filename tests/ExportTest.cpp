@@ -0,0 +1,377 @@
+// Tests the binary export stream by round-tripping ExportWriter output through ExportReader.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "../src/exceptions/ClientException.h"
+#include "../src/exceptions/ConnectionException.h"
+#include "../src/export/ExportFormat.h"
+#include "../src/export/ExportReader.h"
+#include "../src/export/ExportSink.h"
+#include "../src/export/ExportWriter.h"
+
+namespace {
+
+    using namespace nut::export_format;
+    using Rows = std::vector<std::vector<std::string>>;
+    using Kinds = std::map<std::string, uint8_t>;
+
+    const std::chrono::system_clock::time_point T0{std::chrono::milliseconds(1700000000000)};
+
+    int failures = 0;
+
+    void check(const bool condition, const std::string& description) {
+        if (!condition) {
+            std::cerr << "FAILED: " << description << std::endl;
+            ++failures;
+        }
+    }
+
+    /**
+     * Keeps the bytes of every connection separately. A failed write keeps half of its bytes, as a collector
+     * would see when the connection drops mid-frame, and the next frame opens a new connection.
+     */
+    class MemorySink : public nut::ExportSink {
+        public:
+            std::vector<std::string> connections;
+            bool fail_next_write = false;
+
+            bool begin_frame() override {
+                if (m_connected) {
+                    return false;
+                }
+                connections.emplace_back();
+                m_connected = true;
+                return true;
+            }
+
+            void write(const std::string& data) override {
+                if (fail_next_write) {
+                    fail_next_write = false;
+                    m_connected = false;
+                    connections.back().append(data, 0, data.size() / 2);
+                    throw nut::ConnectionException("Simulated send failure.");
+                }
+                connections.back() += data;
+            }
+
+        private:
+            bool m_connected = false;
+    };
+
+    Rows rows(const std::string& ups_name, const std::vector<std::pair<std::string, std::string>>& values) {
+        Rows result;
+        for (const auto& [name, value] : values) {
+            result.push_back({ "VAR", ups_name, name, value });
+        }
+        return result;
+    }
+
+    std::set<std::string> describe(const nut::ExportFrame& frame) {
+        std::set<std::string> changes;
+        for (const nut::ExportChange& change : frame.changes) {
+            changes.insert(change.ups_name + " " + change.var_name + (change.removed ? " removed" : "=" + change.value));
+        }
+        return changes;
+    }
+
+    std::vector<nut::ExportFrame> decode(const std::string& stream, const size_t chunk_size) {
+        nut::ExportReader reader;
+        std::vector<nut::ExportFrame> frames;
+
+        for (size_t position = 0; position < stream.size(); position += chunk_size) {
+            reader.feed(stream.data() + position, std::min(chunk_size, stream.size() - position));
+            nut::ExportFrame frame;
+            while (reader.next(frame)) {
+                frames.emplace_back(std::move(frame));
+            }
+        }
+
+        return frames;
+    }
+
+    // Change kind of every change in every frame of a complete stream, keyed by "ups var".
+    std::vector<Kinds> change_kinds(const std::string& stream) {
+        std::vector<Kinds> frames;
+        std::map<uint64_t, std::string> ups_names;
+        std::map<uint64_t, std::string> var_names;
+        size_t position = 0;
+
+        while (position < stream.size()) {
+            if (stream.compare(position, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) == 0) {
+                position += sizeof(MAGIC) + 1;
+                ups_names.clear();
+                var_names.clear();
+                continue;
+            }
+
+            const auto record = static_cast<uint8_t>(stream[position++]);
+            uint64_t id;
+            uint64_t number;
+            std::string text;
+
+            if (record == DEFINE_UPS || record == DEFINE_VAR) {
+                get_varint(stream, position, id);
+                get_string(stream, position, text);
+                (record == DEFINE_UPS ? ups_names : var_names)[id] = text;
+                continue;
+            }
+
+            uint64_t num_changes;
+            get_varint(stream, position, number);
+            get_varint(stream, position, num_changes);
+            Kinds& kinds = frames.emplace_back();
+
+            for (uint64_t i = 0; i < num_changes; ++i) {
+                uint64_t ups_id;
+                uint64_t var_id;
+                get_varint(stream, position, ups_id);
+                get_varint(stream, position, var_id);
+                const auto kind = static_cast<uint8_t>(stream[position++]);
+                kinds[ups_names[ups_id] + " " + var_names[var_id]] = kind;
+
+                if (kind == STRING) {
+                    get_string(stream, position, text);
+                } else if (kind == NUMBER) {
+                    ++position;
+                    get_varint(stream, position, number);
+                } else if (kind == DELTA) {
+                    get_varint(stream, position, number);
+                }
+            }
+        }
+
+        return frames;
+    }
+
+    void test_round_trip() {
+        auto owned_sink = std::make_unique<MemorySink>();
+        MemorySink& sink = *owned_sink;
+        nut::ExportWriter writer(std::move(owned_sink));
+
+        writer.write("ups0", rows("ups0", {
+            { "battery.charge", "100" },
+            { "input.voltage", "230.0" },
+            { "ups.status", "OL" },
+            { "ambient.offset", "-0" },
+            { "device.part", "007" },
+            { "battery.tiny", "0.0000000001" },
+            { "output.current", "-12.5" }
+        }), T0);
+
+        writer.write("ups0", rows("ups0", {
+            { "battery.charge", "99" },
+            { "input.voltage", "231.5" },
+            { "ups.status", "OB" },
+            { "ambient.offset", "-0" },
+            { "device.part", "007" },
+            { "battery.tiny", "0.0000000001" }
+        }), T0 + std::chrono::milliseconds(1500));
+
+        const uint64_t bytes_before = writer.get_bytes_written();
+        writer.write("ups0", rows("ups0", {
+            { "battery.charge", "99" },
+            { "input.voltage", "231.5" },
+            { "ups.status", "OB" },
+            { "ambient.offset", "-0" },
+            { "device.part", "007" },
+            { "battery.tiny", "0.0000000001" }
+        }), T0 + std::chrono::milliseconds(3000));
+        check(writer.get_bytes_written() == bytes_before, "unchanged snapshot writes nothing");
+
+        writer.write("ups0", rows("ups0", {
+            { "battery.charge", "99" },
+            { "input.voltage", "231" },
+            { "ups.status", "OB" },
+            { "ambient.offset", "-0" },
+            { "device.part", "007" },
+            { "battery.tiny", "0.0000000001" }
+        }), T0 + std::chrono::milliseconds(4000));
+
+        writer.write("ups1", rows("ups1", { { "battery.charge", "50" } }), T0 + std::chrono::milliseconds(4500));
+
+        // Changes made before the first complete connection ends.
+        const std::string complete = sink.connections.at(0);
+
+        sink.fail_next_write = true;
+        bool failed = false;
+        try {
+            writer.write("ups0", rows("ups0", { { "battery.charge", "98" } }), T0 + std::chrono::milliseconds(5000));
+        } catch (const nut::ConnectionException&) {
+            failed = true;
+        }
+        check(failed, "sink failure is passed to the caller");
+
+        writer.write("ups0", rows("ups0", {
+            { "battery.charge", "97" },
+            { "input.voltage", "231" },
+            { "ups.status", "OB" },
+            { "ambient.offset", "-0" },
+            { "device.part", "007" },
+            { "battery.tiny", "0.0000000001" }
+        }), T0 + std::chrono::milliseconds(6000));
+
+        check(sink.connections.size() == 2, "write after a failure opens a new segment");
+        if (sink.connections.size() != 2) {
+            return;
+        }
+
+        const std::set<std::string> expected_first = {
+            "ups0 battery.charge=100", "ups0 input.voltage=230.0", "ups0 ups.status=OL", "ups0 ambient.offset=-0",
+            "ups0 device.part=007", "ups0 battery.tiny=0.0000000001", "ups0 output.current=-12.5"
+        };
+        const std::set<std::string> expected_second = {
+            "ups0 battery.charge=99", "ups0 input.voltage=231.5", "ups0 ups.status=OB", "ups0 output.current removed"
+        };
+        const std::set<std::string> expected_after_restart = {
+            "ups0 battery.charge=97", "ups0 input.voltage=231", "ups0 ups.status=OB", "ups0 ambient.offset=-0",
+            "ups0 device.part=007", "ups0 battery.tiny=0.0000000001"
+        };
+
+        for (const size_t chunk_size : { size_t{1}, size_t{3}, size_t{7}, complete.size() }) {
+            const std::string label = "chunk size " + std::to_string(chunk_size) + ": ";
+            const std::vector<nut::ExportFrame> frames = decode(sink.connections[0], chunk_size);
+
+            check(frames.size() == 4, label + "every complete frame decodes, the truncated one is held back");
+            if (frames.size() != 4) {
+                continue;
+            }
+            check(describe(frames[0]) == expected_first, label + "first frame carries every value");
+            check(describe(frames[1]) == expected_second, label + "second frame carries changes and removal");
+            check(describe(frames[2]) == std::set<std::string>{ "ups0 input.voltage=231" }, label + "scale change");
+            check(describe(frames[3]) == std::set<std::string>{ "ups1 battery.charge=50" }, label + "second UPS");
+            check(frames[0].timestamp == T0, label + "first timestamp");
+            check(frames[1].timestamp == T0 + std::chrono::milliseconds(1500), label + "delta timestamp");
+            check(frames[3].timestamp == T0 + std::chrono::milliseconds(4500), label + "last timestamp");
+        }
+
+        const std::vector<nut::ExportFrame> restarted = decode(sink.connections[1], 5);
+        check(restarted.size() == 1 && describe(restarted[0]) == expected_after_restart,
+              "new segment resends every value");
+        check(!restarted.empty() && restarted[0].timestamp == T0 + std::chrono::milliseconds(6000),
+              "new segment resends the absolute timestamp");
+
+        // One reader across both segments, as when reading rotated files back to back.
+        const std::vector<nut::ExportFrame> joined = decode(complete + sink.connections[1], 11);
+        check(joined.size() == 5 && describe(joined[4]) == expected_after_restart, "reader restarts at a new header");
+
+        const std::vector<Kinds> kinds = change_kinds(complete);
+        check(kinds.size() == 4, "format: four frames in first segment");
+        if (kinds.size() == 4) {
+            check(kinds[0].at("ups0 battery.charge") == NUMBER, "format: integer is NUMBER");
+            check(kinds[0].at("ups0 input.voltage") == NUMBER, "format: decimal is NUMBER");
+            check(kinds[0].at("ups0 output.current") == NUMBER, "format: negative decimal is NUMBER");
+            check(kinds[0].at("ups0 ups.status") == STRING, "format: text is STRING");
+            check(kinds[0].at("ups0 ambient.offset") == STRING, "format: -0 falls back to STRING");
+            check(kinds[0].at("ups0 device.part") == STRING, "format: leading zero falls back to STRING");
+            check(kinds[0].at("ups0 battery.tiny") == STRING, "format: scale above 9 falls back to STRING");
+            check(kinds[1].at("ups0 battery.charge") == DELTA, "format: same scale is DELTA");
+            check(kinds[1].at("ups0 input.voltage") == DELTA, "format: same scale decimal is DELTA");
+            check(kinds[1].at("ups0 output.current") == REMOVED, "format: missing variable is REMOVED");
+            check(kinds[2].at("ups0 input.voltage") == NUMBER, "format: scale change resends NUMBER");
+        }
+
+        const std::vector<Kinds> restarted_kinds = change_kinds(sink.connections[1]);
+        check(restarted_kinds.size() == 1 &&
+              std::none_of(restarted_kinds[0].begin(), restarted_kinds[0].end(), [](const auto& kind) {
+                  return kind.second == DELTA;
+              }), "format: new segment never starts with DELTA");
+    }
+
+    void test_socket_send_timeout() {
+        const std::string path = "/tmp/nutpp-export-test-" + std::to_string(::getpid()) + ".sock";
+        std::remove(path.c_str());
+
+        // A collector that accepts connections into its backlog but never reads from them.
+        const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listener, 4) != 0) {
+            check(false, "socket sink: create collector socket");
+            return;
+        }
+
+        nut::UnixSocketSink sink(path, std::chrono::milliseconds(100));
+        check(sink.begin_frame(), "socket sink: first frame starts a segment");
+
+        const std::string frame(1 << 20, 'x');
+        const auto start = std::chrono::steady_clock::now();
+        bool timed_out = false;
+        try {
+            for (int i = 0; i < 64; ++i) {
+                sink.write(frame);
+            }
+        } catch (const nut::ConnectionException&) {
+            timed_out = true;
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        check(timed_out, "socket sink: write to a stalled collector throws ConnectionException");
+        check(elapsed < std::chrono::seconds(5), "socket sink: write gives up after the send timeout");
+        check(sink.begin_frame(), "socket sink: next frame reconnects and starts a new segment");
+
+        ::close(listener);
+        std::remove(path.c_str());
+    }
+
+    void test_malformed_stream() {
+        nut::ExportReader reader;
+        reader.feed("XXXXX", 5);
+        nut::ExportFrame frame;
+        bool rejected = false;
+
+        try {
+            (void) reader.next(frame);
+        } catch (const nut::ClientException&) {
+            rejected = true;
+        }
+
+        check(rejected, "stream without header is rejected");
+    }
+}
+
+int main() {
+    test_round_trip();
+    test_socket_send_timeout();
+    test_malformed_stream();
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,173 @@
+// Tests SSL modes of Server against FakeUpsd with and without STARTTLS support.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../src/Server.h"
+#include "../src/exceptions/ConnectionException.h"
+#include "../tools/FakeUpsd.h"
+
+namespace {
+
+    // Exit code telling ctest the test was skipped.
+    constexpr int SKIPPED = 77;
+
+    int failures = 0;
+
+    void check(const bool condition, const std::string& description) {
+        if (!condition) {
+            std::cerr << "FAILED: " << description << std::endl;
+            ++failures;
+        }
+    }
+
+    std::shared_ptr<nut::Server> make_server(const nut::FakeUpsd& upsd, const nut::SSLMode ssl_mode,
+                                             const bool remember_refusal = false, const bool verify = false) {
+        std::shared_ptr<nut::Server> server = nut::Server::create("127.0.0.1", upsd.get_port());
+        server->set_ssl_mode(ssl_mode, verify);
+        server->set_remember_tls_refusal(remember_refusal);
+        return server;
+    }
+
+    bool query_works(const nut::Server& server) {
+        return server.get_var("ups0", "ups.load") == "10";
+    }
+
+    void test_plain(const nut::FakeUpsd& tls_upsd) {
+        const int starttls_before = tls_upsd.get_starttls_requests();
+        const auto server = make_server(tls_upsd, nut::SSLMode::PLAIN);
+        server->connect();
+
+        check(!server->get_connection_stats().tls_active, "PLAIN: connection is not encrypted");
+        check(!server->get_connection_stats().tls_skipped, "PLAIN: tls_skipped is not set");
+        check(tls_upsd.get_starttls_requests() == starttls_before, "PLAIN: no STARTTLS is sent");
+        check(query_works(*server), "PLAIN: GET VAR succeeds");
+    }
+
+    void test_try_with_tls(const nut::FakeUpsd& tls_upsd) {
+        const auto server = make_server(tls_upsd, nut::SSLMode::TRY, true);
+        server->connect();
+
+        check(server->get_connection_stats().tls_active, "TRY: TLS is established when offered");
+        check(!server->get_connection_stats().tls_skipped, "TRY: STARTTLS is not skipped");
+        check(server->get_connection_stats().connect_count == 1, "TRY: connect is counted");
+        check(query_works(*server), "TRY: GET VAR succeeds over TLS");
+    }
+
+    void test_require_with_tls(const nut::FakeUpsd& tls_upsd) {
+        const auto server = make_server(tls_upsd, nut::SSLMode::REQUIRE);
+        server->connect();
+
+        check(server->get_connection_stats().tls_active, "REQUIRE: TLS is established");
+        check(query_works(*server), "REQUIRE: GET VAR succeeds over TLS");
+    }
+
+    void test_require_without_tls(const nut::FakeUpsd& plain_upsd) {
+        const auto server = make_server(plain_upsd, nut::SSLMode::REQUIRE);
+        bool refused = false;
+
+        try {
+            server->connect();
+        } catch (const nut::ConnectionException&) {
+            refused = true;
+        }
+
+        check(refused, "REQUIRE: connect fails when upsd refuses STARTTLS");
+        check(!server->get_connection_stats().tls_active, "REQUIRE: failed connect is not reported as TLS");
+    }
+
+    void test_try_without_tls(const nut::FakeUpsd& plain_upsd) {
+        // Without opting in, every connect attempts STARTTLS again.
+        for (int i = 0; i < 2; ++i) {
+            const int starttls_before = plain_upsd.get_starttls_requests();
+            const auto server = make_server(plain_upsd, nut::SSLMode::TRY);
+            server->connect();
+
+            check(!server->get_connection_stats().tls_active, "TRY: falls back to plain text");
+            check(!server->get_connection_stats().tls_skipped, "TRY: STARTTLS is not skipped without opt-in");
+            check(plain_upsd.get_starttls_requests() == starttls_before + 1, "TRY: STARTTLS is sent without opt-in");
+            check(query_works(*server), "TRY: GET VAR succeeds after fallback");
+        }
+    }
+
+    void test_try_remembers_refusal(const nut::FakeUpsd& plain_upsd) {
+        const auto first = make_server(plain_upsd, nut::SSLMode::TRY, true);
+        first->connect();
+        check(!first->get_connection_stats().tls_skipped, "TRY cache: first connect attempts STARTTLS");
+
+        const int starttls_before = plain_upsd.get_starttls_requests();
+        const auto second = make_server(plain_upsd, nut::SSLMode::TRY, true);
+        second->connect();
+
+        check(second->get_connection_stats().tls_skipped, "TRY cache: refusal is remembered");
+        check(!second->get_connection_stats().tls_active, "TRY cache: connection is plain text");
+        check(plain_upsd.get_starttls_requests() == starttls_before, "TRY cache: STARTTLS is not sent again");
+        check(query_works(*second), "TRY cache: GET VAR succeeds");
+
+        second->reconnect();
+        check(second->get_connection_stats().tls_skipped, "TRY cache: reconnect also skips STARTTLS");
+        check(second->get_connection_stats().connect_count == 2, "TRY cache: reconnect is counted");
+
+        const auto verifying = make_server(plain_upsd, nut::SSLMode::TRY, true, true);
+        verifying->connect();
+        check(!verifying->get_connection_stats().tls_skipped, "TRY cache: never applied with certificate verification");
+        check(plain_upsd.get_starttls_requests() == starttls_before + 1, "TRY cache: verifying server sends STARTTLS");
+    }
+}
+
+int main() {
+    nut::Server::init_ssl("", false);
+
+    nut::FakeUpsd tls_upsd;
+    tls_upsd.enable_tls();
+    tls_upsd.start();
+
+    nut::FakeUpsd plain_upsd;
+    plain_upsd.start();
+
+    // A libupsclient built without SSL support cannot take part in the TLS cases.
+    try {
+        const auto probe = make_server(tls_upsd, nut::SSLMode::REQUIRE);
+        probe->connect();
+    } catch (const nut::ConnectionException& e) {
+        if (tls_upsd.get_tls_sessions() == 0) {
+            std::cout << "SKIPPED: libupsclient has no SSL support (" << e.what() << ")" << std::endl;
+            return SKIPPED;
+        }
+        throw;
+    }
+
+    test_plain(tls_upsd);
+    test_try_with_tls(tls_upsd);
+    test_require_with_tls(tls_upsd);
+    test_require_without_tls(plain_upsd);
+    test_try_without_tls(plain_upsd);
+    test_try_remembers_refusal(plain_upsd);
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Tests VariableCache and authenticated writes against FakeUpsd.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../src/Server.h"
+#include "../src/UPS.h"
+#include "../src/VariableCache.h"
+#include "../src/exceptions/AuthenticationException.h"
+#include "../src/exceptions/ClientException.h"
+#include "../src/exceptions/VariableException.h"
+#include "../tools/FakeUpsd.h"
+
+namespace {
+
+    int failures = 0;
+
+    void check(const bool condition, const std::string& description) {
+        if (!condition) {
+            std::cerr << "FAILED: " << description << std::endl;
+            ++failures;
+        }
+    }
+
+    template <typename Exception>
+    bool throws(const std::function<void()>& action) {
+        try {
+            action();
+        } catch (const Exception&) {
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "unexpected exception: " << e.what() << std::endl;
+        }
+        return false;
+    }
+
+    std::shared_ptr<nut::Server> make_server(const nut::FakeUpsd& upsd) {
+        std::shared_ptr<nut::Server> server = nut::Server::create("127.0.0.1", upsd.get_port());
+        server->set_ssl_mode(nut::SSLMode::PLAIN);
+        server->connect();
+        return server;
+    }
+
+    void test_refresh(const nut::FakeUpsd& upsd) {
+        const auto server = make_server(upsd);
+        const nut::UPS ups = server->get_ups("ups0");
+
+        const int requests_before = upsd.get_requests();
+        const nut::VariableCache cache = ups.get_variable_cache();
+
+        // LIST RW, four GET TYPE, one LIST ENUM and one LIST RANGE; no GET DESC.
+        check(upsd.get_requests() - requests_before == 7, "refresh: sends one request per type and list only");
+        check(cache.get_variables().size() == 4, "refresh: every writable variable is cached");
+        check(!cache.contains("ups.status"), "refresh: read-only variable is not cached");
+
+        const int requests_after_refresh = upsd.get_requests();
+        const nut::VariableInfo& sensitivity = cache.get_info("input.sensitivity");
+        check(sensitivity.has(nut::VariableInfo::RW) && sensitivity.has(nut::VariableInfo::ENUM), "refresh: ENUM flags");
+        check(sensitivity.enum_values.size() == 3, "refresh: enum values");
+        check(sensitivity.description == "Description of input.sensitivity", "get_info: description is fetched");
+        check(upsd.get_requests() - requests_after_refresh == 1, "get_info: description costs one request");
+
+        (void) cache.get_info("input.sensitivity");
+        check(upsd.get_requests() - requests_after_refresh == 1, "get_info: description is fetched only once");
+
+        const nut::VariableInfo& transfer = cache.get_info("input.transfer.high");
+        check(transfer.has(nut::VariableInfo::RANGE) && transfer.ranges.size() == 2, "refresh: ranges");
+        check(cache.get_info("ups.id").max_length == 8, "refresh: string length");
+        check(cache.get_info("ups.delay.shutdown").has(nut::VariableInfo::NUMBER), "refresh: NUMBER flag");
+    }
+
+    void test_local_validation(const nut::FakeUpsd& upsd) {
+        const auto server = make_server(upsd);
+        const nut::VariableCache cache = server->get_ups("ups0").get_variable_cache();
+        const int requests_before = upsd.get_requests();
+
+        check(cache.is_valid("input.sensitivity", "high"), "validate: enum value accepted");
+        check(cache.is_valid("input.transfer.high", "285"), "validate: value in second range accepted");
+        check(!cache.is_valid("input.sensitivity", "extreme"), "validate: unknown enum value rejected");
+        check(!cache.is_valid("input.transfer.high", "275"), "validate: value between ranges rejected");
+        check(!cache.is_valid("ups.delay.shutdown", "soon"), "validate: non-number rejected");
+        check(!cache.is_valid("ups.id", "123456789"), "validate: too long string rejected");
+        check(!cache.is_valid("ups.status", "OB"), "validate: read-only variable rejected");
+
+        check(throws<nut::VariableException>([&] { cache.set_variable("input.sensitivity", "extreme"); }),
+              "set_variable: invalid value throws VariableException");
+        check(upsd.get_requests() == requests_before, "set_variable: invalid writes never reach upsd");
+    }
+
+    void test_authenticated_write(const nut::FakeUpsd& upsd) {
+        const auto server = make_server(upsd);
+        const nut::VariableCache cache = server->get_ups("ups1").get_variable_cache();
+
+        check(throws<nut::AuthenticationException>([&] { cache.set_variable("input.sensitivity", "low"); }),
+              "set_variable: rejected without authenticate()");
+
+        const auto authenticated = make_server(upsd);
+        authenticated->authenticate("admin", "secret \"pass\"");
+        const nut::VariableCache writable = authenticated->get_ups("ups1").get_variable_cache();
+        writable.set_variable("input.sensitivity", "low");
+        check(authenticated->get_var("ups1", "input.sensitivity") == "low", "set_variable: value is written");
+
+        check(throws<nut::VariableException>([&] { writable.get_ups().set_variable("input.sensitivity", "extreme"); }),
+              "set_var: upsd INVALID-VALUE maps to VariableException");
+        check(throws<nut::AuthenticationException>([&] { authenticated->authenticate("admin", "secret \"pass\""); }),
+              "authenticate: second login on one session is rejected");
+
+        authenticated->reconnect();
+        writable.set_variable("input.sensitivity", "high");
+        check(authenticated->get_var("ups1", "input.sensitivity") == "high", "reconnect: credentials are sent again");
+
+        const auto wrong = make_server(upsd);
+        wrong->authenticate("admin", "wrong");
+        check(throws<nut::AuthenticationException>([&] { wrong->set_var("ups1", "input.sensitivity", "low"); }),
+              "set_var: wrong password throws AuthenticationException");
+
+        check(throws<nut::ClientException>([&] { authenticated->authenticate("ad min", "x"); }),
+              "authenticate: user name with whitespace is rejected");
+    }
+
+    void test_pipeline_error(const nut::FakeUpsd& upsd) {
+        const auto server = make_server(upsd);
+
+        check(throws<nut::VariableException>([&] { (void) server->get_var_types("ups0", { "ups.id", "nope", "ups.load" }); }),
+              "get_var_types: ERR reply is thrown");
+        check(server->get_var("ups0", "ups.load") == "10", "get_var_types: connection stays in sync after ERR");
+    }
+}
+
+int main() {
+    nut::FakeUpsd upsd(2);
+    upsd.add_user("admin", "secret \"pass\"");
+    upsd.start();
+
+    test_refresh(upsd);
+    test_local_validation(upsd);
+    test_authenticated_write(upsd);
+    test_pipeline_error(upsd);
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,507 @@
+// Minimal in-process stand-in for upsd, used to exercise the client without a real NUT server.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "FakeUpsd.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../src/exceptions/ConnectionException.h"
+
+namespace nut {
+
+    namespace {
+        std::vector<std::string> tokenize(const std::string& line) {
+            std::vector<std::string> tokens;
+            std::string current;
+            bool quoted = false;
+            bool in_token = false;
+
+            for (size_t i = 0; i < line.size(); ++i) {
+                const char c = line[i];
+                if (c == '\\' && quoted && i + 1 < line.size()) {
+                    current += line[++i];
+                } else if (c == '"') {
+                    quoted = !quoted;
+                    in_token = true;
+                } else if (c == ' ' && !quoted) {
+                    if (in_token) {
+                        tokens.emplace_back(std::move(current));
+                        current.clear();
+                        in_token = false;
+                    }
+                } else {
+                    current += c;
+                    in_token = true;
+                }
+            }
+
+            if (in_token) {
+                tokens.emplace_back(std::move(current));
+            }
+
+            return tokens;
+        }
+
+        bool parse_number(const std::string& value, double& out) {
+            try {
+                size_t consumed;
+                out = std::stod(value, &consumed);
+                return consumed == value.size();
+            } catch (const std::logic_error&) {
+                return false;
+            }
+        }
+
+        bool send_all(const int fd, SSL* ssl, const std::string& data) {
+            size_t sent = 0;
+            while (sent < data.size()) {
+                const ssize_t result = ssl != nullptr
+                    ? SSL_write(ssl, data.data() + sent, static_cast<int>(data.size() - sent))
+                    : ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if (result <= 0) {
+                    if (result < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                sent += static_cast<size_t>(result);
+            }
+            return true;
+        }
+    }
+
+    FakeUpsd::FakeUpsd(const int num_ups, const std::chrono::microseconds latency) :
+        m_latency(latency)
+    {
+        for (int i = 0; i < num_ups; ++i) {
+            Device& device = m_devices["ups" + std::to_string(i)];
+            device.description = "Fake UPS " + std::to_string(i);
+            device.variables = {
+                { "battery.charge", "100" },
+                { "battery.runtime", "3600" },
+                { "device.serial", "FAKE" + std::to_string(i) },
+                { "input.voltage", "230.0" },
+                { "ups.load", std::to_string(10 + i % 80) },
+                { "ups.model", "Fake UPS" },
+                { "ups.status", "OL" },
+                { "input.sensitivity", "medium" },
+                { "input.transfer.high", "260" },
+                { "ups.delay.shutdown", "20" },
+                { "ups.id", "fake" + std::to_string(i) }
+            };
+            device.writable = {
+                { "input.sensitivity", { "ENUM", { "low", "medium", "high" }, {} } },
+                { "input.transfer.high", { "RANGE", {}, { { "250", "270" }, { "280", "290" } } } },
+                { "ups.delay.shutdown", { "NUMBER", {}, {} } },
+                { "ups.id", { "STRING:8", {}, {} } }
+            };
+        }
+    }
+
+    void FakeUpsd::add_user(const std::string& username, const std::string& password) {
+        m_users[username] = password;
+    }
+
+    FakeUpsd::~FakeUpsd() {
+        stop();
+        SSL_CTX_free(m_tls_context);
+    }
+
+    void FakeUpsd::enable_tls() {
+        EVP_PKEY* key = nullptr;
+        EVP_PKEY_CTX* key_context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+        const bool key_ok = key_context != nullptr &&
+            EVP_PKEY_keygen_init(key_context) == 1 &&
+            EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_context, NID_X9_62_prime256v1) == 1 &&
+            EVP_PKEY_keygen(key_context, &key) == 1;
+        EVP_PKEY_CTX_free(key_context);
+
+        X509* certificate = key_ok ? X509_new() : nullptr;
+        bool certificate_ok = false;
+        if (certificate != nullptr) {
+            X509_NAME* name = X509_get_subject_name(certificate);
+            certificate_ok =
+                ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1) == 1 &&
+                X509_gmtime_adj(X509_getm_notBefore(certificate), 0) != nullptr &&
+                X509_gmtime_adj(X509_getm_notAfter(certificate), 24 * 60 * 60) != nullptr &&
+                X509_set_pubkey(certificate, key) == 1 &&
+                X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                           reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0) == 1 &&
+                X509_set_issuer_name(certificate, name) == 1 &&
+                X509_sign(certificate, key, EVP_sha256()) != 0;
+        }
+
+        SSL_CTX* context = certificate_ok ? SSL_CTX_new(TLS_server_method()) : nullptr;
+        const bool context_ok = context != nullptr &&
+            SSL_CTX_use_certificate(context, certificate) == 1 &&
+            SSL_CTX_use_PrivateKey(context, key) == 1;
+
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+
+        if (!context_ok) {
+            SSL_CTX_free(context);
+            throw ConnectionException("Failed to create self-signed TLS certificate.");
+        }
+
+        // No resumption is offered, so skip the TLS 1.3 tickets written after the handshake.
+        SSL_CTX_set_num_tickets(context, 0);
+
+        // OpenSSL writes with write() rather than send(MSG_NOSIGNAL); like upsd, ignore SIGPIPE so a client
+        // hanging up mid-reply ends only its own session.
+        std::signal(SIGPIPE, SIG_IGN);
+
+        SSL_CTX_free(m_tls_context);
+        m_tls_context = context;
+    }
+
+    void FakeUpsd::start(const int port) {
+        m_listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (m_listen_fd < 0) {
+            throw ConnectionException(std::string("socket: ") + std::strerror(errno));
+        }
+
+        const int enable = 1;
+        ::setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<uint16_t>(port));
+
+        if (::bind(m_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(m_listen_fd, SOMAXCONN) != 0) {
+            const std::string error = std::strerror(errno);
+            ::close(m_listen_fd);
+            m_listen_fd = -1;
+            throw ConnectionException("bind: " + error);
+        }
+
+        socklen_t length = sizeof(address);
+        ::getsockname(m_listen_fd, reinterpret_cast<sockaddr*>(&address), &length);
+        m_port = ntohs(address.sin_port);
+
+        m_running = true;
+        m_accept_thread = std::thread(&FakeUpsd::accept_loop, this);
+    }
+
+    void FakeUpsd::stop() {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+
+        // Close only after the accept thread has exited, it still reads the descriptor until then.
+        ::shutdown(m_listen_fd, SHUT_RDWR);
+        m_accept_thread.join();
+        ::close(m_listen_fd);
+        m_listen_fd = -1;
+
+        std::unique_lock<std::mutex> lock(m_clients_mutex);
+        for (const int fd : m_client_fds) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        m_clients_cv.wait(lock, [this] {
+            return m_client_fds.empty();
+        });
+    }
+
+    void FakeUpsd::accept_loop() {
+        while (m_running) {
+            const int fd = ::accept(m_listen_fd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+
+            const int enable = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+            std::lock_guard<std::mutex> lock(m_clients_mutex);
+            m_client_fds.push_back(fd);
+            std::thread(&FakeUpsd::serve, this, fd).detach();
+        }
+    }
+
+    void FakeUpsd::serve(const int fd) {
+        std::string buffer;
+        char chunk[1024];
+        bool open = true;
+        SSL* ssl = nullptr;
+        Session session;
+
+        while (open) {
+            const ssize_t received = ssl != nullptr
+                ? SSL_read(ssl, chunk, sizeof(chunk))
+                : ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            buffer.append(chunk, static_cast<size_t>(received));
+
+            size_t newline;
+            while (open && (newline = buffer.find('\n')) != std::string::npos) {
+                std::string line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+
+                const std::vector<std::string> tokens = tokenize(line);
+                if (tokens.empty()) {
+                    continue;
+                }
+                ++m_requests;
+
+                if (m_latency.count() > 0) {
+                    std::this_thread::sleep_for(m_latency);
+                }
+
+                if (tokens[0] == "STARTTLS") {
+                    ++m_starttls_requests;
+
+                    if (m_tls_context != nullptr && ssl == nullptr) {
+                        if (!send_all(fd, nullptr, "OK STARTTLS\n")) {
+                            open = false;
+                            break;
+                        }
+
+                        // Anything the client pipelined after STARTTLS was plain text and is discarded.
+                        buffer.clear();
+                        ssl = SSL_new(m_tls_context);
+                        if (ssl == nullptr || SSL_set_fd(ssl, fd) != 1 || SSL_accept(ssl) != 1) {
+                            open = false;
+                            break;
+                        }
+                        ++m_tls_sessions;
+                        continue;
+                    }
+                }
+
+                open = send_all(fd, ssl, respond(tokens, session)) && tokens[0] != "LOGOUT";
+            }
+        }
+
+        if (ssl != nullptr) {
+            SSL_free(ssl);
+        }
+
+        std::lock_guard<std::mutex> lock(m_clients_mutex);
+        for (auto it = m_client_fds.begin(); it != m_client_fds.end(); ++it) {
+            if (*it == fd) {
+                m_client_fds.erase(it);
+                break;
+            }
+        }
+        ::close(fd);
+        m_clients_cv.notify_all();
+    }
+
+    std::string FakeUpsd::respond(const std::vector<std::string>& tokens, Session& session) {
+        const std::string& command = tokens[0];
+
+        if (command == "STARTTLS") {
+            return "ERR FEATURE-NOT-CONFIGURED\n";
+        }
+
+        if (command == "LOGOUT") {
+            return "OK Goodbye\n";
+        }
+
+        if (command == "USERNAME" && tokens.size() == 2) {
+            if (!session.username.empty()) {
+                return "ERR ALREADY-SET-USERNAME\n";
+            }
+            session.username = tokens[1];
+            return "OK\n";
+        }
+
+        if (command == "PASSWORD" && tokens.size() == 2) {
+            if (!session.password.empty()) {
+                return "ERR ALREADY-SET-PASSWORD\n";
+            }
+            session.password = tokens[1];
+            return "OK\n";
+        }
+
+        if (command == "SET" && tokens.size() == 5 && tokens[1] == "VAR") {
+            return set_variable(tokens, session);
+        }
+
+        std::shared_lock<std::shared_mutex> lock(m_devices_mutex);
+
+        if (command == "LIST" && tokens.size() == 2 && tokens[1] == "UPS") {
+            std::string response = "BEGIN LIST UPS\n";
+            for (const auto& [name, device] : m_devices) {
+                response += "UPS " + name + " \"" + device.description + "\"\n";
+            }
+            return response + "END LIST UPS\n";
+        }
+
+        if ((command == "LIST" || command == "GET") && tokens.size() >= 3) {
+            const auto device = m_devices.find(tokens[2]);
+            if (device == m_devices.end()) {
+                return "ERR UNKNOWN-UPS\n";
+            }
+
+            if (command == "LIST" && tokens[1] == "VAR" && tokens.size() == 3) {
+                std::string response = "BEGIN LIST VAR " + tokens[2] + "\n";
+                for (const auto& [name, value] : device->second.variables) {
+                    response += "VAR " + tokens[2] + " " + name + " \"" + value + "\"\n";
+                }
+                return response + "END LIST VAR " + tokens[2] + "\n";
+            }
+
+            if (command == "LIST" && tokens[1] == "RW" && tokens.size() == 3) {
+                std::string response = "BEGIN LIST RW " + tokens[2] + "\n";
+                for (const auto& [name, writable] : device->second.writable) {
+                    response += "RW " + tokens[2] + " " + name + " \"" + device->second.variables.at(name) + "\"\n";
+                }
+                return response + "END LIST RW " + tokens[2] + "\n";
+            }
+
+            if (command == "GET" && tokens[1] == "UPSDESC" && tokens.size() == 3) {
+                return "UPSDESC " + tokens[2] + " \"" + device->second.description + "\"\n";
+            }
+
+            if (tokens.size() == 4) {
+                const auto variable = device->second.variables.find(tokens[3]);
+                if (variable == device->second.variables.end()) {
+                    return "ERR VAR-NOT-SUPPORTED\n";
+                }
+
+                const std::string prefix = tokens[2] + " " + tokens[3];
+                const auto writable = device->second.writable.find(tokens[3]);
+
+                if (command == "GET" && tokens[1] == "VAR") {
+                    return "VAR " + prefix + " \"" + variable->second + "\"\n";
+                }
+
+                if (command == "GET" && tokens[1] == "DESC") {
+                    return "DESC " + prefix + " \"Description of " + tokens[3] + "\"\n";
+                }
+
+                if (command == "GET" && tokens[1] == "TYPE") {
+                    if (writable == device->second.writable.end()) {
+                        return "TYPE " + prefix + " STRING:64\n";
+                    }
+                    return "TYPE " + prefix + " RW " + writable->second.type + "\n";
+                }
+
+                if (command == "LIST" && tokens[1] == "ENUM") {
+                    std::string response = "BEGIN LIST ENUM " + prefix + "\n";
+                    if (writable != device->second.writable.end()) {
+                        for (const std::string& value : writable->second.enum_values) {
+                            response += "ENUM " + prefix + " \"" + value + "\"\n";
+                        }
+                    }
+                    return response + "END LIST ENUM " + prefix + "\n";
+                }
+
+                if (command == "LIST" && tokens[1] == "RANGE") {
+                    std::string response = "BEGIN LIST RANGE " + prefix + "\n";
+                    if (writable != device->second.writable.end()) {
+                        for (const auto& [min, max] : writable->second.ranges) {
+                            response += "RANGE " + prefix + " \"" + min + "\" \"" + max + "\"\n";
+                        }
+                    }
+                    return response + "END LIST RANGE " + prefix + "\n";
+                }
+            }
+        }
+
+        return "ERR UNKNOWN-COMMAND\n";
+    }
+
+    std::string FakeUpsd::set_variable(const std::vector<std::string>& tokens, const Session& session) {
+        if (session.username.empty()) {
+            return "ERR USERNAME-REQUIRED\n";
+        }
+        if (session.password.empty()) {
+            return "ERR PASSWORD-REQUIRED\n";
+        }
+
+        const auto user = m_users.find(session.username);
+        if (user == m_users.end() || user->second != session.password) {
+            return "ERR ACCESS-DENIED\n";
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_devices_mutex);
+
+        const auto device = m_devices.find(tokens[2]);
+        if (device == m_devices.end()) {
+            return "ERR UNKNOWN-UPS\n";
+        }
+
+        const auto variable = device->second.variables.find(tokens[3]);
+        if (variable == device->second.variables.end()) {
+            return "ERR VAR-NOT-SUPPORTED\n";
+        }
+
+        const auto writable = device->second.writable.find(tokens[3]);
+        if (writable == device->second.writable.end()) {
+            return "ERR READONLY\n";
+        }
+
+        const Writable& type = writable->second;
+        const std::string& value = tokens[4];
+        double number = 0;
+
+        if (type.type == "ENUM" &&
+            std::find(type.enum_values.begin(), type.enum_values.end(), value) == type.enum_values.end()) {
+            return "ERR INVALID-VALUE\n";
+        }
+
+        if ((type.type == "RANGE" || type.type == "NUMBER") && !parse_number(value, number)) {
+            return "ERR INVALID-VALUE\n";
+        }
+
+        if (type.type == "RANGE" &&
+            std::none_of(type.ranges.begin(), type.ranges.end(), [number](const auto& range) {
+                return number >= std::stod(range.first) && number <= std::stod(range.second);
+            })) {
+            return "ERR INVALID-VALUE\n";
+        }
+
+        if (type.type.rfind("STRING:", 0) == 0 && value.size() > std::stoul(type.type.substr(7))) {
+            return "ERR TOO-LONG\n";
+        }
+
+        variable->second = value;
+        return "OK\n";
+    }
+} // nut
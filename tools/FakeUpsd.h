@@ -0,0 +1,160 @@
+// Minimal in-process stand-in for upsd, used to exercise the client without a real NUT server.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef NUT_PLUS_PLUS_FAKEUPSD_H
+#define NUT_PLUS_PLUS_FAKEUPSD_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <thread>
+#include <vector>
+
+struct ssl_ctx_st;
+
+namespace nut {
+
+    /**
+     * Serves LIST UPS, LIST VAR, GET VAR and GET UPSDESC for a fixed set of UPS over plain TCP on 127.0.0.1.
+     * Each UPS also has writable variables answering LIST RW, GET TYPE, GET DESC, LIST ENUM, LIST RANGE and
+     * SET VAR, where SET VAR requires USERNAME and PASSWORD of a user added with add_user().
+     * STARTTLS is refused unless enable_tls() was called, so clients using UPSCLI_CONN_TRYSSL fall back to plain
+     * text by default.
+     */
+    class FakeUpsd {
+        private:
+            struct Writable {
+                // Type tokens after "RW", e.g. "ENUM" or "STRING:8".
+                std::string type;
+                std::vector<std::string> enum_values;
+                std::vector<std::pair<std::string, std::string>> ranges;
+            };
+
+            struct Device {
+                std::string description;
+                std::map<std::string, std::string> variables;
+                std::map<std::string, Writable> writable;
+            };
+
+            // Credentials sent on one connection.
+            struct Session {
+                std::string username;
+                std::string password;
+            };
+
+            // Guards variable values, which SET VAR changes while other clients read them.
+            mutable std::shared_mutex m_devices_mutex;
+            std::map<std::string, Device> m_devices;
+            std::map<std::string, std::string> m_users;
+            std::chrono::microseconds m_latency;
+            int m_listen_fd = -1;
+            int m_port = 0;
+            std::atomic<bool> m_running{false};
+            std::thread m_accept_thread;
+            std::mutex m_clients_mutex;
+            std::condition_variable m_clients_cv;
+            // Client threads are detached; stop() waits for this list to drain instead of joining them.
+            std::vector<int> m_client_fds;
+            ssl_ctx_st* m_tls_context = nullptr;
+            std::atomic<int> m_starttls_requests{0};
+            std::atomic<int> m_tls_sessions{0};
+            std::atomic<int> m_requests{0};
+
+            void accept_loop();
+            void serve(int fd);
+            [[nodiscard]] std::string respond(const std::vector<std::string>& tokens, Session& session);
+            [[nodiscard]] std::string set_variable(const std::vector<std::string>& tokens, const Session& session);
+        public:
+            /**
+             * @param num_ups number of fake UPS to serve, named ups0, ups1, ...
+             * @param latency artificial delay added before every response
+             */
+            explicit FakeUpsd(int num_ups = 1, std::chrono::microseconds latency = std::chrono::microseconds(0));
+            ~FakeUpsd();
+
+            FakeUpsd(const FakeUpsd&) = delete;
+            FakeUpsd& operator=(const FakeUpsd&) = delete;
+
+            /**
+             * Accept STARTTLS, presenting a freshly generated self-signed certificate for CN=localhost.
+             * Must be called before start(). Ignores SIGPIPE process-wide, as upsd does.
+             * @throws ConnectionException
+             */
+            void enable_tls();
+
+            /**
+             * Allow user to set variables. Must be called before start().
+             * @param username name sent with USERNAME
+             * @param password password sent with PASSWORD
+             */
+            void add_user(const std::string& username, const std::string& password);
+
+            /**
+             * Listen on 127.0.0.1 and start serving.
+             * @param port port to bind, 0 picks a free port
+             * @throws ConnectionException
+             */
+            void start(int port = 0);
+
+            /**
+             * Close listening socket and all client connections.
+             */
+            void stop();
+
+            /**
+             * Get port the server is bound to.
+             * @return int port
+             */
+            [[nodiscard]] int get_port() const {
+                return m_port;
+            }
+
+            /**
+             * Get number of STARTTLS commands received, whether or not TLS was enabled.
+             * @return int count
+             */
+            [[nodiscard]] int get_starttls_requests() const {
+                return m_starttls_requests;
+            }
+
+            /**
+             * Get number of request lines received, STARTTLS included.
+             * @return int count
+             */
+            [[nodiscard]] int get_requests() const {
+                return m_requests;
+            }
+
+            /**
+             * Get number of completed TLS handshakes.
+             * @return int count
+             */
+            [[nodiscard]] int get_tls_sessions() const {
+                return m_tls_sessions;
+            }
+    };
+} // nut
+
+#endif //NUT_PLUS_PLUS_FAKEUPSD_H
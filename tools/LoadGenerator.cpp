@@ -0,0 +1,472 @@
+// Load generator for measuring upsd and client scaling limits.
+//
+// Copyright (C) 2025 NUT-Plus-Plus <nutpp+ryanjhuston@comcast.net>
+//
+// This project is a C++ wrapper for the Network UPS Tools (NUT) library.
+// It is not affiliated with the official NUT project.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FakeUpsd.h"
+#include "../src/Server.h"
+#include "../src/exceptions/AuthenticationException.h"
+#include "../src/exceptions/ClientException.h"
+#include "../src/exceptions/CommandException.h"
+#include "../src/exceptions/ConnectionException.h"
+#include "../src/exceptions/UPSException.h"
+#include "../src/exceptions/VariableException.h"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    enum Operation { GET_VAR, LIST_VAR, LIST_UPS, NUM_OPERATIONS };
+
+    const char* const OPERATION_NAMES[NUM_OPERATIONS] = { "GET VAR", "LIST VAR", "LIST UPS" };
+
+    struct Options {
+        std::string hostname = "localhost";
+        int port = 3493;
+        bool fake = false;
+        bool fake_tls = false;
+        int fake_ups = 1;
+        int fake_latency_us = 0;
+        int clients = 8;
+        double duration = 10.0;
+        // Total requests per second across all clients. 0 selects closed-loop mode.
+        double rate = 0.0;
+        double mix[NUM_OPERATIONS] = { 70.0, 20.0, 10.0 };
+        std::string ups_name;
+        std::string var_name = "ups.load";
+        nut::SSLMode ssl_mode = nut::SSLMode::TRY;
+        bool remember_tls_refusal = false;
+    };
+
+    /**
+     * Log-linear histogram of latencies in microseconds. Values below 64 are counted exactly, larger ones in 32
+     * buckets per power of two, so percentiles are within about 3% while memory stays fixed however long the run.
+     */
+    class LatencyHistogram {
+        public:
+            void record(const uint32_t value) {
+                ++m_counts[bucket(value)];
+                ++m_count;
+                m_max = std::max(m_max, value);
+            }
+
+            void merge(const LatencyHistogram& other) {
+                for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+                    m_counts[i] += other.m_counts[i];
+                }
+                m_count += other.m_count;
+                m_max = std::max(m_max, other.m_max);
+            }
+
+            [[nodiscard]] uint64_t count() const {
+                return m_count;
+            }
+
+            [[nodiscard]] uint32_t max() const {
+                return m_max;
+            }
+
+            // Upper bound of the bucket holding the sample of the given rank, capped at the largest sample.
+            [[nodiscard]] uint32_t percentile(const double fraction) const {
+                if (m_count == 0) {
+                    return 0;
+                }
+
+                const auto rank = static_cast<uint64_t>(fraction * static_cast<double>(m_count - 1) + 0.5);
+                uint64_t seen = 0;
+                for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+                    seen += m_counts[i];
+                    if (seen > rank) {
+                        return std::min(upper_bound(i), m_max);
+                    }
+                }
+                return m_max;
+            }
+
+        private:
+            static constexpr int LINEAR_BITS = 6;
+            static constexpr int SUB_BUCKET_BITS = 5;
+            static constexpr size_t LINEAR_BUCKETS = size_t{1} << LINEAR_BITS;
+            static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+            static constexpr size_t NUM_BUCKETS = LINEAR_BUCKETS + (32 - LINEAR_BITS) * SUB_BUCKETS;
+
+            std::vector<uint64_t> m_counts = std::vector<uint64_t>(NUM_BUCKETS, 0);
+            uint64_t m_count = 0;
+            uint32_t m_max = 0;
+
+            static size_t bucket(const uint32_t value) {
+                if (value < LINEAR_BUCKETS) {
+                    return value;
+                }
+
+                int exponent = LINEAR_BITS;
+                while (exponent < 31 && (value >> (exponent + 1)) != 0) {
+                    ++exponent;
+                }
+
+                const int shift = exponent - SUB_BUCKET_BITS;
+                const size_t sub_bucket = (value >> shift) - SUB_BUCKETS;
+                return LINEAR_BUCKETS + static_cast<size_t>(exponent - LINEAR_BITS) * SUB_BUCKETS + sub_bucket;
+            }
+
+            static uint32_t upper_bound(const size_t index) {
+                if (index < LINEAR_BUCKETS) {
+                    return static_cast<uint32_t>(index);
+                }
+
+                const size_t exponent = LINEAR_BITS + (index - LINEAR_BUCKETS) / SUB_BUCKETS;
+                const uint64_t sub_bucket = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+                const uint64_t bound = ((SUB_BUCKETS + sub_bucket + 1) << (exponent - SUB_BUCKET_BITS)) - 1;
+                return static_cast<uint32_t>(std::min<uint64_t>(bound, UINT32_MAX));
+            }
+    };
+
+    struct ClientStats {
+        LatencyHistogram latencies[NUM_OPERATIONS];
+        std::map<std::string, uint64_t> errors;
+        nut::ConnectionStats connection;
+    };
+
+    void print_usage(const char* program) {
+        std::cerr << "Usage: " << program << " [options]\n"
+                  << "  --host HOST          upsd hostname (default localhost)\n"
+                  << "  --port PORT          upsd port (default 3493)\n"
+                  << "  --fake               start an in-process fake upsd and target it\n"
+                  << "  --fake-ups N         number of UPS served by the fake upsd (default 1)\n"
+                  << "  --fake-latency US    delay the fake upsd adds to every response\n"
+                  << "  --fake-tls           let the fake upsd accept STARTTLS with a self-signed certificate\n"
+                  << "  --clients N          concurrent clients, one connection each (default 8)\n"
+                  << "  --duration SECONDS   length of run (default 10)\n"
+                  << "  --rate RPS           open-loop total request rate, 0 for closed loop (default 0)\n"
+                  << "  --mix G:L:U          weights of GET VAR, LIST VAR and LIST UPS (default 70:20:10)\n"
+                  << "  --ups NAME           UPS to query (default first UPS reported by LIST UPS)\n"
+                  << "  --var NAME           variable for GET VAR (default ups.load)\n"
+                  << "  --ssl MODE           plain, try or require (default try)\n"
+                  << "  --remember-tls-refusal  skip STARTTLS in try mode for hosts that recently refused it\n";
+    }
+
+    bool parse_mix(const std::string& value, double (&mix)[NUM_OPERATIONS]) {
+        size_t start = 0;
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            const size_t end = value.find(':', start);
+            if ((i < NUM_OPERATIONS - 1) == (end == std::string::npos)) {
+                return false;
+            }
+            mix[i] = std::stod(value.substr(start, end - start));
+            if (mix[i] < 0) {
+                return false;
+            }
+            start = end + 1;
+        }
+        return mix[GET_VAR] + mix[LIST_VAR] + mix[LIST_UPS] > 0;
+    }
+
+    bool parse_options(const int argc, char** argv, Options& options) {
+        try {
+            for (int i = 1; i < argc; ++i) {
+                const std::string arg = argv[i];
+                const bool has_value = i + 1 < argc;
+
+                if (arg == "--fake") {
+                    options.fake = true;
+                } else if (arg == "--fake-tls") {
+                    options.fake_tls = true;
+                } else if (arg == "--remember-tls-refusal") {
+                    options.remember_tls_refusal = true;
+                } else if (!has_value) {
+                    return false;
+                } else if (arg == "--host") {
+                    options.hostname = argv[++i];
+                } else if (arg == "--port") {
+                    options.port = std::stoi(argv[++i]);
+                } else if (arg == "--fake-ups") {
+                    options.fake_ups = std::stoi(argv[++i]);
+                } else if (arg == "--fake-latency") {
+                    options.fake_latency_us = std::stoi(argv[++i]);
+                } else if (arg == "--clients") {
+                    options.clients = std::stoi(argv[++i]);
+                } else if (arg == "--duration") {
+                    options.duration = std::stod(argv[++i]);
+                } else if (arg == "--rate") {
+                    options.rate = std::stod(argv[++i]);
+                } else if (arg == "--mix") {
+                    if (!parse_mix(argv[++i], options.mix)) {
+                        return false;
+                    }
+                } else if (arg == "--ups") {
+                    options.ups_name = argv[++i];
+                } else if (arg == "--var") {
+                    options.var_name = argv[++i];
+                } else if (arg == "--ssl") {
+                    const std::string mode = argv[++i];
+                    if (mode == "plain") {
+                        options.ssl_mode = nut::SSLMode::PLAIN;
+                    } else if (mode == "try") {
+                        options.ssl_mode = nut::SSLMode::TRY;
+                    } else if (mode == "require") {
+                        options.ssl_mode = nut::SSLMode::REQUIRE;
+                    } else {
+                        return false;
+                    }
+                } else {
+                    return false;
+                }
+            }
+        } catch (const std::logic_error&) {
+            return false;
+        }
+
+        return options.clients > 0 && options.duration > 0 && options.rate >= 0 && options.fake_ups > 0;
+    }
+
+    std::string classify(const std::exception_ptr& error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const nut::ConnectionException&) {
+            return "ConnectionException";
+        } catch (const nut::AuthenticationException&) {
+            return "AuthenticationException";
+        } catch (const nut::VariableException&) {
+            return "VariableException";
+        } catch (const nut::CommandException&) {
+            return "CommandException";
+        } catch (const nut::UPSException&) {
+            return "UPSException";
+        } catch (const nut::ClientException&) {
+            return "ClientException";
+        } catch (const nut::NUTException&) {
+            return "NUTException";
+        } catch (const std::exception&) {
+            return "std::exception";
+        } catch (...) {
+            return "unknown";
+        }
+    }
+
+    void perform(const nut::Server& server, const Options& options, const Operation operation) {
+        switch (operation) {
+            case GET_VAR:
+                static_cast<void>(server.get_var(options.ups_name, options.var_name));
+                break;
+            case LIST_VAR:
+                static_cast<void>(server.get_var_list(options.ups_name, "VAR"));
+                break;
+            case LIST_UPS:
+                static_cast<void>(server.get_var_list("UPS"));
+                break;
+            default:
+                break;
+        }
+    }
+
+    void run_client(const Options& options, const int index, const Clock::time_point start,
+                    const Clock::time_point end, ClientStats& stats) {
+        std::mt19937 rng(static_cast<unsigned>(index) + 1);
+        std::discrete_distribution<int> pick(std::begin(options.mix), std::end(options.mix));
+
+        const std::shared_ptr<nut::Server> server = nut::Server::create(options.hostname, options.port);
+        server->set_ssl_mode(options.ssl_mode);
+        server->set_remember_tls_refusal(options.remember_tls_refusal);
+        bool connected = false;
+        bool ever_connected = false;
+
+        // Open loop: each client sends on a fixed schedule, staggered so clients do not fire in bursts.
+        const bool open_loop = options.rate > 0;
+        const auto interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(open_loop ? options.clients / options.rate : 0.0));
+        Clock::time_point next_send = start + interval * index / options.clients;
+
+        while (true) {
+            Clock::time_point intended;
+            if (open_loop) {
+                intended = next_send;
+                next_send += interval;
+                if (intended >= end) {
+                    break;
+                }
+                std::this_thread::sleep_until(intended);
+            } else {
+                intended = Clock::now();
+                if (intended >= end) {
+                    break;
+                }
+            }
+
+            const auto operation = static_cast<Operation>(pick(rng));
+
+            try {
+                if (!connected) {
+                    if (ever_connected) {
+                        server->reconnect();
+                    } else {
+                        server->connect();
+                    }
+                    connected = true;
+                    ever_connected = true;
+                }
+
+                perform(*server, options, operation);
+
+                // Measured from the intended send time so a stalled server is not hidden by the schedule.
+                const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - intended);
+                stats.latencies[operation].record(static_cast<uint32_t>(std::min<int64_t>(latency.count(), UINT32_MAX)));
+            } catch (...) {
+                const std::exception_ptr error = std::current_exception();
+                const std::string name = classify(error);
+                ++stats.errors[name];
+
+                if (name == "ConnectionException") {
+                    connected = false;
+                    if (!open_loop) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    }
+                }
+            }
+        }
+
+        stats.connection = server->get_connection_stats();
+    }
+
+    void print_latency_row(const char* name, const LatencyHistogram& latencies) {
+        std::printf("  %-10s %10llu %9u %9u %9u %9u %9u\n", name, static_cast<unsigned long long>(latencies.count()),
+                    latencies.percentile(0.50), latencies.percentile(0.90), latencies.percentile(0.99),
+                    latencies.percentile(0.999), latencies.max());
+    }
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<nut::FakeUpsd> fake;
+    if (options.fake) {
+        fake = std::make_unique<nut::FakeUpsd>(options.fake_ups, std::chrono::microseconds(options.fake_latency_us));
+        if (options.fake_tls) {
+            fake->enable_tls();
+        }
+        fake->start();
+        options.hostname = "127.0.0.1";
+        options.port = fake->get_port();
+    }
+
+    if (options.ups_name.empty()) {
+        try {
+            const std::shared_ptr<nut::Server> server = nut::Server::create(options.hostname, options.port);
+            server->set_ssl_mode(options.ssl_mode);
+            server->set_remember_tls_refusal(options.remember_tls_refusal);
+            server->connect();
+            const std::vector<std::vector<std::string>> ups_list = server->get_var_list("UPS");
+            if (ups_list.empty()) {
+                std::cerr << "No UPS reported by " << options.hostname << ":" << options.port << std::endl;
+                return 1;
+            }
+            options.ups_name = ups_list.front().at(1);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to query UPS list: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<ClientStats> stats(static_cast<size_t>(options.clients));
+    std::vector<std::thread> threads;
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+
+    for (int i = 0; i < options.clients; ++i) {
+        threads.emplace_back(run_client, std::cref(options), i, start, end, std::ref(stats[static_cast<size_t>(i)]));
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    LatencyHistogram merged[NUM_OPERATIONS];
+    LatencyHistogram all;
+    std::map<std::string, uint64_t> errors;
+    uint64_t failed = 0;
+    uint64_t connects = 0;
+    uint64_t tls_connections = 0;
+    std::chrono::microseconds connect_time{0};
+
+    for (ClientStats& client : stats) {
+        for (int op = 0; op < NUM_OPERATIONS; ++op) {
+            merged[op].merge(client.latencies[op]);
+        }
+        for (const auto& [name, count] : client.errors) {
+            errors[name] += count;
+            failed += count;
+        }
+        connects += client.connection.connect_count;
+        connect_time += client.connection.total_connect_time;
+        tls_connections += client.connection.tls_active ? 1 : 0;
+    }
+
+    for (const LatencyHistogram& op_latencies : merged) {
+        all.merge(op_latencies);
+    }
+
+    std::printf("target      %s:%d UPS %s%s\n", options.hostname.c_str(), options.port, options.ups_name.c_str(),
+                options.fake ? " (fake upsd)" : "");
+    if (options.rate > 0) {
+        std::printf("clients     %d, open loop at %.1f req/s\n", options.clients, options.rate);
+    } else {
+        std::printf("clients     %d, closed loop\n", options.clients);
+    }
+    std::printf("duration    %.2f s\n", elapsed);
+    std::printf("requests    %llu ok, %llu failed\n", static_cast<unsigned long long>(all.count()),
+                static_cast<unsigned long long>(failed));
+    std::printf("throughput  %.1f req/s\n", static_cast<double>(all.count()) / elapsed);
+    std::printf("connects    %llu, mean %.0f us, %llu of %d clients on TLS\n\n",
+                static_cast<unsigned long long>(connects),
+                connects > 0 ? static_cast<double>(connect_time.count()) / static_cast<double>(connects) : 0.0,
+                static_cast<unsigned long long>(tls_connections), options.clients);
+
+    std::printf("  %-10s %10s %9s %9s %9s %9s %9s\n", "latency", "count", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+    for (int op = 0; op < NUM_OPERATIONS; ++op) {
+        print_latency_row(OPERATION_NAMES[op], merged[op]);
+    }
+    print_latency_row("all", all);
+
+    if (!errors.empty()) {
+        std::printf("\nerrors\n");
+        for (const auto& [name, count] : errors) {
+            std::printf("  %-24s %llu\n", name.c_str(), static_cast<unsigned long long>(count));
+        }
+    }
+
+    return 0;
+}